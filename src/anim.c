@@ -0,0 +1,188 @@
+#include <zephyr/sys/printk.h>
+
+#include "anim.h"
+#include "i2c_queue.h"
+#include "perf.h"
+
+// Smile, blinked by the chip for two seconds
+const struct anim_key anim_success[] = {
+    ANIM_SPRITE(SPRITE_SMILE, LEFT, 0),
+    ANIM_SPRITE(SPRITE_SMILE, RIGHT, 0),
+    ANIM_BLINK(LED_BLINK_2HZ, ANIM_MS(2000)),
+    ANIM_BLINK(LED_BLINK_OFF, 0),
+    ANIM_END,
+};
+
+// Crying face pulsing through the dimming levels
+const struct anim_key anim_failure[] = {
+    ANIM_SPRITE(SPRITE_CRY, LEFT, 0),
+    ANIM_SPRITE(SPRITE_CRY, RIGHT, 0),
+    ANIM_FADE(LED_DIMMING_MAX, 0, ANIM_MS(600)),
+    ANIM_FADE(0, LED_DIMMING_MAX, ANIM_MS(600)),
+    ANIM_FADE(LED_DIMMING_MAX, 0, ANIM_MS(600)),
+    ANIM_FADE(0, LED_DIMMING_MAX, ANIM_MS(600)),
+    ANIM_END,
+};
+
+// Played on the system work queue, one tick per frame. Ticks without a key
+// change or fade step return at once.
+static const struct anim_key *seq;
+static size_t key_idx;
+static uint8_t key_frame;
+static uint8_t dim_level;
+static uint8_t saved_dimming;
+static atomic_t running;
+
+static PERF_STAT_DEFINE_HIRES(tick_stat, "anim tick");
+static int64_t play_start;
+static uint32_t play_ms;
+static uint32_t i2c_start_transactions, i2c_start_bytes;
+static uint32_t i2c_transactions, i2c_bytes;
+
+static void anim_tick_handler(struct k_work *work);
+static K_WORK_DEFINE(anim_tick_work, anim_tick_handler);
+
+static void anim_timer_expiry(struct k_timer *timer)
+{
+    k_work_submit(&anim_tick_work);
+}
+
+static K_TIMER_DEFINE(anim_timer, anim_timer_expiry, NULL);
+
+static void set_dimming(uint8_t level)
+{
+    if (level != dim_level) {
+        dim_level = level;
+        led_set_dimming(level);
+    }
+}
+
+// Returns true when the key changed the frame buffer
+static bool apply_key(const struct anim_key *key)
+{
+    switch (key->op) {
+    case ANIM_OP_SPRITE:
+        led_draw_sprite(key->a, key->b);
+        return true;
+    case ANIM_OP_CLEAR:
+        led_off_all();
+        return true;
+    case ANIM_OP_BLINK:
+        led_set_blink(key->a);
+        break;
+    case ANIM_OP_DIM:
+        set_dimming(key->a);
+        break;
+    case ANIM_OP_FADE:
+        set_dimming(key->frames ? key->a : key->b);
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+// Fade level for the current frame, the last frame of the key lands on b
+static void step_fade(const struct anim_key *key)
+{
+    int32_t span = (int32_t)key->b - key->a;
+
+    set_dimming(key->a + span * key_frame / key->frames);
+}
+
+static void finish(void)
+{
+    uint32_t transactions, bytes;
+
+    atomic_clear(&running);
+    k_timer_stop(&anim_timer);
+
+    // leave the chip as it was before the sequence
+    led_set_blink(LED_BLINK_OFF);
+    set_dimming(saved_dimming);
+
+    play_ms += k_uptime_get() - play_start;
+    i2c_queue_get_totals(&transactions, &bytes);
+    i2c_transactions += transactions - i2c_start_transactions;
+    i2c_bytes += bytes - i2c_start_bytes;
+}
+
+static void anim_tick_handler(struct k_work *work)
+{
+    if (!atomic_get(&running)) {
+        return;
+    }
+
+    uint32_t start = perf_start_hires();
+    bool draw = false;
+
+    while (1) {
+        const struct anim_key *key = &seq[key_idx];
+
+        if (key->op == ANIM_OP_END) {
+            finish();
+            break;
+        }
+
+        if (key_frame == 0) {
+            draw |= apply_key(key);
+        } else if (key->op == ANIM_OP_FADE) {
+            step_fade(key);
+        }
+
+        if (key_frame < key->frames) {
+            key_frame++;
+            break;
+        }
+
+        key_idx++;
+        key_frame = 0;
+    }
+
+    if (draw) {
+        led_flush();
+    }
+
+    perf_stop(&tick_stat, start);
+}
+
+// Play seq from its first key, replaces a sequence still running
+void anim_play(const struct anim_key *new_seq)
+{
+    anim_stop();
+
+    seq = new_seq;
+    key_idx = 0;
+    key_frame = 0;
+    saved_dimming = led_get_dimming();
+    dim_level = saved_dimming;
+    play_start = k_uptime_get();
+    i2c_queue_get_totals(&i2c_start_transactions, &i2c_start_bytes);
+
+    atomic_set(&running, 1);
+    k_timer_start(&anim_timer, K_NO_WAIT, K_MSEC(1000 / ANIM_FPS));
+}
+
+void anim_stop(void)
+{
+    k_timer_stop(&anim_timer);
+    k_work_cancel(&anim_tick_work);
+    if (atomic_get(&running)) {
+        finish();
+    }
+}
+
+// Cost per second of animation: tick CPU time at ANIM_FPS, and all i2c0
+// traffic while a sequence was playing
+void anim_print_stats(void)
+{
+#if PERF_ENABLED
+    uint32_t avg = tick_stat.count ? (uint32_t)(tick_stat.total_cyc / tick_stat.count) : 0;
+    uint32_t secs_x100 = MAX(play_ms / 10, 1);
+
+    printk("[perf] anim: %u ms played, cpu %u us/s, i2c %u transactions/s %u bytes/s\n", play_ms,
+           perf_cyc_to_ns(&tick_stat, avg) * ANIM_FPS / 1000, i2c_transactions * 100 / secs_x100,
+           i2c_bytes * 100 / secs_x100);
+    perf_print(&tick_stat);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <zephyr/kernel.h>
+
+#include "led.h"
+
+#define ANIM_FPS 25
+#define ANIM_MS(ms) ((ms) * ANIM_FPS / 1000) // duration in frames
+
+enum anim_op {
+    ANIM_OP_END,
+    ANIM_OP_SPRITE, // draw sprite a on half b
+    ANIM_OP_CLEAR,  // blank the matrix
+    ANIM_OP_BLINK,  // hardware blink at rate a
+    ANIM_OP_DIM,    // hardware dimming level a
+    ANIM_OP_FADE,   // hardware dimming from a to b over the key's frames
+};
+
+// One keyframe. The key is applied, then held for frames ticks before the
+// next one starts; keys with 0 frames take effect in the same tick as the next.
+struct anim_key {
+    uint8_t op;
+    uint8_t a;
+    uint8_t b;
+    uint8_t frames;
+};
+
+#define ANIM_SPRITE(id, half, hold) { ANIM_OP_SPRITE, (id), (half), (hold) }
+#define ANIM_CLEAR(hold) { ANIM_OP_CLEAR, 0, 0, (hold) }
+#define ANIM_BLINK(rate, hold) { ANIM_OP_BLINK, (rate), 0, (hold) }
+#define ANIM_DIM(level, hold) { ANIM_OP_DIM, (level), 0, (hold) }
+#define ANIM_FADE(from, to, frames) { ANIM_OP_FADE, (from), (to), (frames) }
+#define ANIM_END { ANIM_OP_END }
+
+extern const struct anim_key anim_success[];
+extern const struct anim_key anim_failure[];
+
+void anim_play(const struct anim_key *seq);
+void anim_stop(void);
+void anim_print_stats(void);
+
+#endif // ANIM_H
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include "audit.h"
+#include "cts.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(audit, CONFIG_SAFE_AUDIT_LOG_LEVEL);
+
+#if !FIXED_PARTITION_EXISTS(audit_partition)
+#error "audit_partition missing from the devicetree overlay"
+#endif
+
+#define AUDIT_ID_HEAD 0
+#define AUDIT_ID_SLOT(batch) (1 + (batch) % AUDIT_SLOTS)
+#define AUDIT_BATCH_BYTES (AUDIT_BATCH_ENTRIES * sizeof(struct audit_entry))
+#define AUDIT_TX_TIMEOUT K_SECONDS(5)
+#define AUDIT_ATE_BYTES 8 // NVS allocation table entry per item
+
+// the live batches may fill half the partition, the rest keeps garbage
+// collection from running on every write
+BUILD_ASSERT(AUDIT_SLOTS * (AUDIT_BATCH_BYTES + AUDIT_ATE_BYTES) <=
+             FIXED_PARTITION_SIZE(audit_partition) / 2, "audit ring does not fit the partition");
+
+// Identifies our own head, anything else in the partition is a foreign layout
+#define AUDIT_MAGIC 0x54445541 // "AUDT"
+#define AUDIT_LAYOUT_VERSION 1 // bump when the head, the slot ids or the entry change
+
+// Where the next batch goes and the boot count, written after every batch
+struct audit_head {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t boot;
+    uint32_t next_batch;
+} __packed;
+
+static struct nvs_fs fs = {
+    .flash_device = FIXED_PARTITION_DEVICE(audit_partition),
+    .offset = FIXED_PARTITION_OFFSET(audit_partition),
+};
+static struct audit_head head;
+static bool mounted;
+
+// Two RAM batches: one filled by audit_log(), one sealed while its flash write
+// runs. Only the work queue seals and writes.
+static struct audit_entry batch[2][AUDIT_BATCH_ENTRIES];
+static uint8_t batch_count[2];
+static uint8_t active;
+static struct k_spinlock lock;
+
+K_THREAD_STACK_DEFINE(audit_workq_stack, AUDIT_WORKQ_STACK_SIZE);
+static struct k_work_q audit_workq;
+
+static void commit_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(commit_work, commit_handler);
+static void download_handler(struct k_work *work);
+static K_WORK_DEFINE(download_work, download_handler);
+
+static PERF_STAT_DEFINE(commit_stat, "audit commit");
+static PERF_STAT_DEFINE(download_stat, "audit download");
+static uint32_t logged, dropped, batches, write_errors, downloads, download_bytes;
+
+void audit_log(enum audit_event event, uint8_t stage)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint8_t n = batch_count[active];
+
+    // both batches full, the flash write is behind
+    if (n == AUDIT_BATCH_ENTRIES) {
+        dropped++;
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    batch[active][n] = (struct audit_entry){
+        .time_ms = sys_cpu_to_le64(cts_now_ms()),
+        .boot = sys_cpu_to_le16(head.boot),
+        .event = event,
+        .stage = stage,
+    };
+    batch_count[active] = ++n;
+    logged++;
+    k_spin_unlock(&lock, key);
+
+    if (n == AUDIT_BATCH_ENTRIES) {
+        k_work_reschedule_for_queue(&audit_workq, &commit_work, K_NO_WAIT);
+    } else {
+        // a partly filled batch waits for more entries, but not forever
+        k_work_schedule_for_queue(&audit_workq, &commit_work, K_SECONDS(AUDIT_COMMIT_DELAY_S));
+    }
+}
+
+// Write everything logged so far now, e.g. before a planned reset
+void audit_commit(void)
+{
+    k_work_reschedule_for_queue(&audit_workq, &commit_work, K_NO_WAIT);
+}
+
+static int write_head(void)
+{
+    ssize_t ret = nvs_write(&fs, AUDIT_ID_HEAD, &head, sizeof(head));
+
+    return ret < 0 ? ret : 0;
+}
+
+// One NVS item per batch. Reusing the slot id of the oldest batch turns it into
+// garbage, so NVS garbage collection keeps the ring within the partition.
+static void commit_handler(struct k_work *work)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint8_t sealed = active;
+    uint8_t n = batch_count[sealed];
+
+    if (n == 0 || !mounted) {
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    active ^= 1;
+    batch_count[active] = 0;
+    k_spin_unlock(&lock, key);
+
+    uint32_t start = perf_start();
+    ssize_t ret = nvs_write(&fs, AUDIT_ID_SLOT(head.next_batch), batch[sealed],
+                            n * sizeof(struct audit_entry));
+
+    if (ret >= 0) {
+        head.next_batch++;
+        ret = write_head();
+    }
+    perf_stop(&commit_stat, start);
+
+    if (ret < 0) {
+        LOG_ERR("Audit log write failed (%d)", (int)ret);
+        write_errors++;
+    } else {
+        batches++;
+    }
+
+    // entries logged while this batch was written may already fill the other one
+    key = k_spin_lock(&lock);
+    if (batch_count[active] == AUDIT_BATCH_ENTRIES) {
+        k_work_reschedule_for_queue(&audit_workq, &commit_work, K_NO_WAIT);
+    }
+    k_spin_unlock(&lock, key);
+}
+
+// [L2CAP download]
+static struct bt_l2cap_le_chan download_chan;
+static atomic_t download_connected;
+static uint8_t download_buf[AUDIT_BATCH_BYTES];
+
+NET_BUF_POOL_FIXED_DEFINE(audit_tx_pool, 2, BT_L2CAP_SDU_BUF_SIZE(AUDIT_BATCH_BYTES),
+                          CONFIG_BT_CONN_TX_USER_DATA_SIZE, NULL);
+
+// Send len bytes as SDUs no larger than the peer accepts, whole entries each
+static int send_entries(const uint8_t *data, size_t len)
+{
+    size_t sdu = MIN(download_chan.tx.mtu, AUDIT_BATCH_BYTES);
+
+    sdu -= sdu % sizeof(struct audit_entry);
+    if (sdu == 0) {
+        return -EMSGSIZE;
+    }
+
+    while (len > 0) {
+        size_t chunk = MIN(len, sdu);
+        struct net_buf *buf;
+
+        if (!atomic_get(&download_connected)) {
+            return -ENOTCONN;
+        }
+
+        buf = net_buf_alloc(&audit_tx_pool, AUDIT_TX_TIMEOUT);
+        if (!buf) {
+            return -ETIMEDOUT;
+        }
+
+        net_buf_reserve(buf, BT_L2CAP_SDU_CHAN_SEND_RESERVE);
+        net_buf_add_mem(buf, data, chunk);
+
+        int err = bt_l2cap_chan_send(&download_chan.chan, buf);
+        if (err < 0) {
+            net_buf_unref(buf);
+            return err;
+        }
+
+        data += chunk;
+        len -= chunk;
+        download_bytes += chunk;
+    }
+    return 0;
+}
+
+// Runs on the audit work queue, so no batch is written meanwhile. The flash
+// batches go out oldest first, then the entries still in RAM.
+static void download_handler(struct k_work *work)
+{
+    uint32_t first = head.next_batch > AUDIT_SLOTS ? head.next_batch - AUDIT_SLOTS : 0;
+    uint32_t start = perf_start();
+    int err = 0;
+
+    for (uint32_t b = first; b < head.next_batch && !err; b++) {
+        ssize_t len = nvs_read(&fs, AUDIT_ID_SLOT(b), download_buf, sizeof(download_buf));
+
+        if (len > 0) {
+            err = send_entries(download_buf, MIN(len, sizeof(download_buf)));
+        }
+    }
+
+    if (!err) {
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        size_t len = batch_count[active] * sizeof(struct audit_entry);
+
+        memcpy(download_buf, batch[active], len);
+        k_spin_unlock(&lock, key);
+
+        err = send_entries(download_buf, len);
+    }
+
+    if (err) {
+        LOG_ERR("Audit download aborted (%d)", err);
+    } else {
+        perf_stop(&download_stat, start);
+        downloads++;
+    }
+
+    // the end of the log is the end of the channel
+    if (atomic_get(&download_connected)) {
+        (void)bt_l2cap_chan_disconnect(&download_chan.chan);
+    }
+}
+
+static void download_connected_cb(struct bt_l2cap_chan *chan)
+{
+    atomic_set(&download_connected, 1);
+    k_work_submit_to_queue(&audit_workq, &download_work);
+}
+
+static void download_disconnected_cb(struct bt_l2cap_chan *chan)
+{
+    atomic_clear(&download_connected);
+}
+
+// The channel is download only
+static int download_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+    return 0;
+}
+
+static const struct bt_l2cap_chan_ops download_ops = {
+    .connected = download_connected_cb,
+    .disconnected = download_disconnected_cb,
+    .recv = download_recv,
+};
+
+static int download_accept(struct bt_conn *conn, struct bt_l2cap_server *server,
+                           struct bt_l2cap_chan **chan)
+{
+    if (atomic_get(&download_connected)) {
+        return -ENOMEM;
+    }
+
+    download_chan = (struct bt_l2cap_le_chan){ .chan.ops = &download_ops };
+    *chan = &download_chan.chan;
+    return 0;
+}
+
+static struct bt_l2cap_server download_server = {
+    .psm = AUDIT_L2CAP_PSM,
+    .sec_level = BT_SECURITY_L2,
+    .accept = download_accept,
+};
+
+// The audit partition used to be the tail of the settings storage, and a
+// board may still carry settings sectors there. Those and logs of an older
+// layout are erased once, the log starts over at batch 0.
+static int erase_foreign_layout(void)
+{
+    const struct flash_area *fa;
+    int err;
+
+    LOG_WRN("Audit partition holds a foreign layout, erasing it");
+
+    err = flash_area_open(FIXED_PARTITION_ID(audit_partition), &fa);
+    if (err < 0) {
+        return err;
+    }
+    err = flash_area_erase(fa, 0, fa->fa_size);
+    flash_area_close(fa);
+    if (err < 0) {
+        return err;
+    }
+
+    head = (struct audit_head){ .magic = AUDIT_MAGIC, .version = AUDIT_LAYOUT_VERSION };
+    return nvs_mount(&fs);
+}
+
+int audit_init(void)
+{
+    struct flash_pages_info info;
+    ssize_t len = 0;
+    int err;
+
+    k_work_queue_init(&audit_workq);
+    k_work_queue_start(&audit_workq, audit_workq_stack, K_THREAD_STACK_SIZEOF(audit_workq_stack),
+                       AUDIT_WORKQ_PRIORITY, &(struct k_work_queue_config){ .name = "audit" });
+
+    if (!device_is_ready(fs.flash_device)) {
+        LOG_ERR("Audit flash device not ready");
+        return -1;
+    }
+
+    err = flash_get_page_info_by_offs(fs.flash_device, fs.offset, &info);
+    if (err < 0) {
+        LOG_ERR("Could not get audit flash page info (%d)", err);
+        return -1;
+    }
+
+    fs.sector_size = info.size;
+    fs.sector_count = FIXED_PARTITION_SIZE(audit_partition) / info.size;
+
+    // a fresh partition has no head either and is set up the same way
+    err = nvs_mount(&fs);
+    if (err == 0) {
+        len = nvs_read(&fs, AUDIT_ID_HEAD, &head, sizeof(head));
+    }
+    if (err < 0 || len != sizeof(head) || head.magic != AUDIT_MAGIC ||
+        head.version != AUDIT_LAYOUT_VERSION) {
+        err = erase_foreign_layout();
+    }
+    if (err < 0) {
+        LOG_ERR("Could not mount the audit log (%d)", err);
+        return -1;
+    }
+
+    head.boot++;
+    if (write_head() < 0) {
+        LOG_ERR("Could not write the audit log head");
+        return -1;
+    }
+    mounted = true;
+
+    err = bt_l2cap_server_register(&download_server);
+    if (err < 0) {
+        LOG_ERR("Could not register the audit download channel (%d)", err);
+        return -1;
+    }
+
+    LOG_INF("boot %u, %u batches written", head.boot, head.next_batch);
+    audit_log(AUDIT_EVENT_BOOT, 0);
+    return 0;
+}
+
+void audit_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] audit: %u logged, %u dropped, %u batches, %u write errors\n", logged, dropped,
+           batches, write_errors);
+    printk("[perf] audit: %u downloads, %u bytes\n", downloads, download_bytes);
+    perf_print(&commit_stat);
+    perf_print(&download_stat);
+#endif
+}
\ No newline at end of file
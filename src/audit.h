@@ -0,0 +1,46 @@
+#ifndef AUDIT_H
+#define AUDIT_H
+
+#include <zephyr/kernel.h>
+
+// Attempt history kept across resets in the audit partition, an NVS ring of
+// batches. audit_log() only appends to a RAM batch, flash writes happen on the
+// audit work queue.
+
+// A batch is one NVS item. It is not sized to the 4 KiB flash page: an item
+// has to fit a sector next to its allocation entries, and the batch buffer
+// exists five times in RAM (two batches, the download buffer, two L2CAP SDUs).
+// At 384 bytes that is about 2 KiB of RAM instead of 20 KiB, and about ten
+// batches fill a page before NVS needs an erase.
+#define AUDIT_BATCH_ENTRIES 32   // 384 bytes
+#define AUDIT_SLOTS 16           // batches kept in flash, the oldest is overwritten
+#define AUDIT_COMMIT_DELAY_S 30  // a partly filled batch is written after this
+#define AUDIT_WORKQ_STACK_SIZE 1536
+#define AUDIT_WORKQ_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+// LE credit based channel that streams the whole log, oldest entry first,
+// then disconnects. Needs an encrypted link.
+#define AUDIT_L2CAP_PSM 0x0081
+
+enum audit_event {
+    AUDIT_EVENT_BOOT,
+    AUDIT_EVENT_ATTEMPT_FAIL,
+    AUDIT_EVENT_ATTEMPT_OK,
+    AUDIT_EVENT_TIMEOUT,
+    AUDIT_EVENT_OPENED,
+};
+
+// Stored and downloaded as is, little endian
+struct audit_entry {
+    int64_t time_ms; // cts_now_ms(): Unix time once the clock was set, else uptime
+    uint16_t boot; // counts resets, orders entries across them
+    uint8_t event;
+    uint8_t stage; // enum status_stage
+} __packed;
+
+int audit_init(void);
+void audit_log(enum audit_event event, uint8_t stage);
+void audit_commit(void);
+void audit_print_stats(void);
+
+#endif // AUDIT_H
\ No newline at end of file
@@ -1,98 +1,38 @@
+#include <zephyr/logging/log.h>
+
 #include "batterydisplay.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(battery, CONFIG_SAFE_BATTERY_LOG_LEVEL);
 
-static const struct gpio_dt_spec clk = GPIO_DT_SPEC_GET(DT_ALIAS(gpio_clk), gpios);
-static const struct gpio_dt_spec dio = GPIO_DT_SPEC_GET(DT_ALIAS(gpio_dio), gpios);
+static const struct device *const battery = DEVICE_DT_GET(BATTERY_NODE);
 
-static int8_t leveltab[11] = {0x00, 0x20, 0x40, 0x60, 0x70, 0x78, 0x7a, 0x7c, 0x7d, 0x7e, 0x7f}; // Level 0~10
-static uint8_t cmd_dispctrl = DISPLAY_BRIGHTEST + BRIGHTNESS_LEVEL1;
 static int setlevel = 0;
 
+// time the caller spends in display_level(), the transfer itself runs on the driver's work queue
+static PERF_STAT_DEFINE(post_stat, "display_level post");
+
 int batterydisplay_init(void)
 {
-    if (!device_is_ready(clk.port)) {
-        printk("clk GPIO is not ready\n");
+    if (!device_is_ready(battery)) {
+        LOG_ERR("Battery display %s is not ready", battery->name);
         return -1;
     }
 
-    if (!device_is_ready(dio.port)) {
-        printk("dio GPIO is not ready\n");
-        return -1;
-    }
-
-    printk("batterydisplay_init success\n");
+    LOG_INF("batterydisplay_init success");
 
     return 0;
 }
 
 void set_brightness(int brightness)
 {
-    cmd_dispctrl = DISPLAY_BRIGHTEST + brightness;
-}
-
-void set_level(int level)
-{
-    setlevel = level;
-}
-
-void write_byte(int8_t wr_data)
-{
-    uint8_t data = wr_data;
-
-    for (uint8_t i = 0; i < 8; i++) {
-        gpio_pin_configure_dt(&clk, GPIO_OUTPUT);
-        bit_delay();
-
-        if (data & 0x01)
-            gpio_pin_configure_dt(&dio, GPIO_INPUT);
-        else
-            gpio_pin_configure_dt(&dio, GPIO_OUTPUT);
-
-        bit_delay();
-
-        gpio_pin_configure_dt(&clk, GPIO_INPUT);
-        bit_delay();
-
-        data >>= 1;
-    }
-
-    gpio_pin_configure_dt(&clk, GPIO_OUTPUT);
-    gpio_pin_configure_dt(&dio, GPIO_INPUT);
-    bit_delay();
-
-    gpio_pin_configure_dt(&clk, GPIO_INPUT);
-    bit_delay();
-    uint8_t ack = gpio_pin_get_dt(&dio);
-    if (ack == 0) {
-        gpio_pin_configure_dt(&dio, GPIO_OUTPUT);
-    }
-
-    bit_delay();
-    gpio_pin_configure_dt(&clk, GPIO_OUTPUT);
-    bit_delay();
-}
-
-void start(void)
-{
-    gpio_pin_configure_dt(&dio, GPIO_OUTPUT);
-    bit_delay();
-}
-
-void stop(void)
-{
-    gpio_pin_configure_dt(&dio, GPIO_OUTPUT);
-    bit_delay();
-
-    gpio_pin_configure_dt(&clk, GPIO_INPUT);
-    bit_delay();
-
-    gpio_pin_configure_dt(&dio, GPIO_INPUT);
-    bit_delay();
+    tm1651_set_brightness(battery, brightness);
 }
 
 int display_level(uint8_t level)
 {
-    if (level > 10) {
-        printk("Invalid level\n");
+    if (level > TM1651_MAX_LEVEL) {
+        LOG_ERR("Invalid level");
         return -1;
     }
 
@@ -100,25 +40,14 @@ int display_level(uint8_t level)
         return 0;
     }
 
-    set_level(level);
-    printk("display_level: %d\n", level);
-
-    start();
-    write_byte(ADDR_FIXED);
-    stop();
-
-    start();
-    write_byte(ADDR_CMD_00H);
-    write_byte(leveltab[level]);
-    stop();
-
-    start();
-    write_byte(cmd_dispctrl);
-    stop();
+    setlevel = level;
+    LOG_DBG("display_level: %d", level);
 
-    printk("display_level success\n");
+    uint32_t start = perf_start();
+    int err = tm1651_set_level(battery, level);
+    perf_stop(&post_stat, start);
 
-    return 0;
+    return err;
 }
 
 void display_clear(void)
@@ -126,7 +55,8 @@ void display_clear(void)
     display_level(0);
 }
 
-void bit_delay(void)
+void batterydisplay_print_stats(void)
 {
-    k_sleep(K_TICKS(1));
+    perf_print(&post_stat);
+    tm1651_print_stats();
 }
\ No newline at end of file
@@ -1,25 +1,18 @@
 #ifndef BATTERYDISPLAY_H
 #define BATTERYDISPLAY_H
 
-#include <zephyr/drivers/gpio.h>
 #include <zephyr/kernel.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/sys/printk.h>
 
-#define DISPLAY_BRIGHTEST 0x88
-#define BRIGHTNESS_LEVEL1 0x01
+#include "tm1651.h"
 
-#define ADDR_FIXED 0x44
-#define ADDR_CMD_00H 0xC0
+#define BATTERY_NODE DT_NODELABEL(batterydisplay)
 
 int batterydisplay_init(void);
 void set_brightness(int brightness);
 int display_level(uint8_t level);
 void display_clear(void);
-
-void start(void);
-void stop(void);
-void write_byte(int8_t wr_data);
-void bit_delay(void);
+void batterydisplay_print_stats(void);
 
 #endif // BATTERYDISPLAY_H
\ No newline at end of file
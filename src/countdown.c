@@ -0,0 +1,106 @@
+#include <zephyr/sys/printk.h>
+
+#include "countdown.h"
+#include "events.h"
+#include "perf.h"
+
+struct countdown_level {
+    uint8_t min_s;
+    uint8_t level;
+};
+
+static const struct countdown_level levels[] = { COUNTDOWN_LEVELS };
+
+// Everything is derived from the uptime deadline, the timer only decides when
+// to look. A late tick or a slow consumer never stretches the countdown.
+static int64_t start_ms;
+static int64_t deadline_ms;
+static uint32_t ticks;
+static atomic_t running;
+static atomic_t expired; // latched, a full queue may drop EVENT_TIMEOUT
+
+// how late a tick expiry ran past start_ms + n seconds. Both sides come from
+// the uptime clock, so this is timer latency, not drift against real time.
+// tests/countdown checks the deadline against an independent clock.
+static int32_t max_late_ms;
+
+static void countdown_expiry(struct k_timer *timer)
+{
+    int64_t now = k_uptime_get();
+    int32_t late = (int32_t)(now - (start_ms + ++ticks * MSEC_PER_SEC));
+
+    max_late_ms = MAX(max_late_ms, late);
+
+    int64_t remaining = deadline_ms - now;
+    struct app_event ev = { .type = EVENT_TICK, .remaining_ms = MAX(remaining, 0) };
+
+    if (remaining <= 0) {
+        ev.type = EVENT_TIMEOUT;
+        k_timer_stop(timer);
+        atomic_clear(&running);
+        atomic_set(&expired, 1);
+    }
+
+    app_event_post(&ev);
+}
+
+static K_TIMER_DEFINE(countdown_timer, countdown_expiry, NULL);
+
+// Starts the countdown, later calls while it runs are ignored
+void countdown_start(void)
+{
+    if (atomic_set(&running, 1)) {
+        return;
+    }
+
+    atomic_clear(&expired);
+    start_ms = k_uptime_get();
+    deadline_ms = start_ms + COUNTDOWN_SECONDS * MSEC_PER_SEC;
+    ticks = 0;
+    k_timer_start(&countdown_timer, K_SECONDS(1), K_SECONDS(1));
+}
+
+void countdown_stop(void)
+{
+    k_timer_stop(&countdown_timer);
+    atomic_clear(&running);
+}
+
+bool countdown_running(void)
+{
+    return atomic_get(&running);
+}
+
+// True once the deadline passed, whether or not EVENT_TIMEOUT got through
+bool countdown_expired(void)
+{
+    return atomic_get(&expired);
+}
+
+int32_t countdown_remaining_ms(void)
+{
+    if (!countdown_running()) {
+        return 0;
+    }
+    return MAX(deadline_ms - k_uptime_get(), 0);
+}
+
+uint8_t countdown_level(int32_t remaining_ms)
+{
+    // a partly elapsed second still counts as a whole one
+    int32_t remaining_s = DIV_ROUND_UP(remaining_ms, MSEC_PER_SEC);
+
+    for (size_t i = 0; i < ARRAY_SIZE(levels); i++) {
+        if (remaining_s >= levels[i].min_s) {
+            return levels[i].level;
+        }
+    }
+    return 0;
+}
+
+void countdown_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] countdown: %u ticks, max tick lateness %d ms\n", ticks, max_late_ms);
+#endif
+}
\ No newline at end of file
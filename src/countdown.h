@@ -0,0 +1,34 @@
+#ifndef COUNTDOWN_H
+#define COUNTDOWN_H
+
+#include <zephyr/kernel.h>
+
+// Time to enter both codes, counted from the first joystick move
+#ifndef COUNTDOWN_SECONDS
+#define COUNTDOWN_SECONDS 120
+#endif
+
+// Battery display level for the remaining time: at or above min_s seconds left
+// the display shows level. Entries must be sorted by min_s, descending.
+#define COUNTDOWN_LEVELS \
+    { .min_s = 120, .level = 10 }, \
+    { .min_s = 108, .level = 9 }, \
+    { .min_s = 96, .level = 8 }, \
+    { .min_s = 84, .level = 7 }, \
+    { .min_s = 72, .level = 6 }, \
+    { .min_s = 60, .level = 5 }, \
+    { .min_s = 48, .level = 4 }, \
+    { .min_s = 36, .level = 3 }, \
+    { .min_s = 24, .level = 2 }, \
+    { .min_s = 13, .level = 1 }, \
+    { .min_s = 0, .level = 0 }
+
+void countdown_start(void);
+void countdown_stop(void);
+bool countdown_running(void);
+bool countdown_expired(void);
+int32_t countdown_remaining_ms(void);
+uint8_t countdown_level(int32_t remaining_ms);
+void countdown_print_stats(void);
+
+#endif // COUNTDOWN_H
\ No newline at end of file
@@ -22,36 +22,109 @@
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/gatt.h>
 
-static uint8_t ct[10];
-static uint8_t ct_update;
+#include <time.h>
+#include <zephyr/sys/timeutil.h>
+
+#include "cts.h"
+
+#define CT_LEN 10
+#define CT_ADJUST_MANUAL BIT(0)
+
+/* Unix time in ms at uptime 0, set by a write to the characteristic. Readers
+ * add it to k_uptime_get(), dates are only built for the characteristic.
+ */
+static int64_t epoch_offset_ms;
+static bool time_set;
+static struct k_spinlock lock;
+
+static void notify_handler(struct k_work *work);
+static K_WORK_DEFINE(notify_work, notify_handler);
 
 static void ct_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value)
 {
-	/* TODO: Handle value */
+	/* notifications are only sent on adjustments, nothing to start */
+}
+
+/* 'Exact Time 256' with 'Adjust Reason': year, month, day, hours, minutes,
+ * seconds, day of week, 1/256 s fractions, reason. All zero while unknown.
+ */
+static void encode_current_time(uint8_t *buf, uint8_t adjust_reason)
+{
+	struct tm tm;
+	int64_t now_ms;
+	time_t now_s;
+
+	memset(buf, 0, CT_LEN);
+	if (!time_set) {
+		return;
+	}
+
+	now_ms = cts_now_ms();
+	now_s = now_ms / MSEC_PER_SEC;
+	gmtime_r(&now_s, &tm);
+
+	sys_put_le16(tm.tm_year + 1900, buf);
+	buf[2] = tm.tm_mon + 1; /* months starting from 1 */
+	buf[3] = tm.tm_mday;
+	buf[4] = tm.tm_hour;
+	buf[5] = tm.tm_min;
+	buf[6] = tm.tm_sec;
+	buf[7] = tm.tm_wday ? tm.tm_wday : 7; /* Monday = 1 .. Sunday = 7 */
+	buf[8] = (now_ms % MSEC_PER_SEC) * 256 / MSEC_PER_SEC;
+	buf[9] = adjust_reason;
 }
 
 static ssize_t read_ct(struct bt_conn *conn, const struct bt_gatt_attr *attr,
 		       void *buf, uint16_t len, uint16_t offset)
 {
-	const char *value = attr->user_data;
+	uint8_t ct[CT_LEN];
 
-	return bt_gatt_attr_read(conn, attr, buf, len, offset, value,
-				 sizeof(ct));
+	encode_current_time(ct, 0);
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, ct, sizeof(ct));
+}
+
+/* Days in a month of the Gregorian calendar, month starting from 1 */
+static uint8_t days_in_month(uint16_t year, uint8_t month)
+{
+	static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+	return days[month - 1] + (month == 2 && leap);
 }
 
 static ssize_t write_ct(struct bt_conn *conn, const struct bt_gatt_attr *attr,
 			const void *buf, uint16_t len, uint16_t offset,
 			uint8_t flags)
 {
-	uint8_t *value = attr->user_data;
+	const uint8_t *ct = buf;
+	struct tm tm = { 0 };
+
+	if (offset != 0 || len != CT_LEN) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
 
-	if (offset + len > sizeof(ct)) {
-		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	tm.tm_year = sys_get_le16(ct) - 1900;
+	tm.tm_mon = ct[2] - 1;
+	tm.tm_mday = ct[3];
+	tm.tm_hour = ct[4];
+	tm.tm_min = ct[5];
+	tm.tm_sec = ct[6];
+
+	/* timeutil_timegm64() would roll 31 April into May, reject it instead */
+	if (tm.tm_year < 70 || ct[2] < 1 || ct[2] > 12 || ct[3] < 1 ||
+	    ct[3] > days_in_month(sys_get_le16(ct), ct[2]) ||
+	    ct[4] > 23 || ct[5] > 59 || ct[6] > 59) {
+		return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
 	}
 
-	memcpy(value + offset, buf, len);
-	ct_update = 1U;
+	int64_t unix_ms = timeutil_timegm64(&tm) * MSEC_PER_SEC + ct[8] * MSEC_PER_SEC / 256;
+	k_spinlock_key_t key = k_spin_lock(&lock);
 
+	epoch_offset_ms = unix_ms - k_uptime_get();
+	time_set = true;
+	k_spin_unlock(&lock, key);
+
+	k_work_submit(&notify_work);
 	return len;
 }
 
@@ -61,49 +134,34 @@ BT_GATT_SERVICE_DEFINE(cts_cvs,
 	BT_GATT_CHARACTERISTIC(BT_UUID_CTS_CURRENT_TIME, BT_GATT_CHRC_READ |
 			       BT_GATT_CHRC_NOTIFY | BT_GATT_CHRC_WRITE,
 			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
-			       read_ct, write_ct, ct),
+			       read_ct, write_ct, NULL),
 	BT_GATT_CCC(ct_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
-static void generate_current_time(uint8_t *buf)
+/* Unix time in ms once a client has set the clock, the uptime before that */
+int64_t cts_now_ms(void)
 {
-	uint16_t year;
-
-	/* 'Exact Time 256' contains 'Day Date Time' which contains
-	 * 'Date Time' - characteristic contains fields for:
-	 * year, month, day, hours, minutes and seconds.
-	 */
-
-	year = sys_cpu_to_le16(2015);
-	memcpy(buf,  &year, 2); /* year */
-	buf[2] = 5U; /* months starting from 1 */
-	buf[3] = 30U; /* day */
-	buf[4] = 12U; /* hours */
-	buf[5] = 45U; /* minutes */
-	buf[6] = 30U; /* seconds */
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int64_t offset = epoch_offset_ms;
 
-	/* 'Day of Week' part of 'Day Date Time' */
-	buf[7] = 1U; /* day of week starting from 1 */
-
-	/* 'Fractions 256 part of 'Exact Time 256' */
-	buf[8] = 0U;
-
-	/* Adjust reason */
-	buf[9] = 0U; /* No update, change, etc */
+	k_spin_unlock(&lock, key);
+	return k_uptime_get() + offset;
 }
 
 void cts_init(void)
 {
-	/* Simulate current time for Current Time Service */
-	generate_current_time(ct);
+	/* the clock stays unknown until a client writes the current time */
+}
+
+static void notify_handler(struct k_work *work)
+{
+	cts_notify();
 }
 
 void cts_notify(void)
-{	/* Current Time Service updates only when time is changed */
-	if (!ct_update) {
-		return;
-	}
+{	/* Current Time Service updates only when time is adjusted */
+	uint8_t ct[CT_LEN];
 
-	ct_update = 0U;
-	bt_gatt_notify(NULL, &cts_cvs.attrs[1], &ct, sizeof(ct));
+	encode_current_time(ct, CT_ADJUST_MANUAL);
+	bt_gatt_notify(NULL, &cts_cvs.attrs[1], ct, sizeof(ct));
 }
\ No newline at end of file
@@ -12,8 +12,12 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stdint.h>
+
 void cts_init(void);
 void cts_notify(void);
+int64_t cts_now_ms(void);
 
 #ifdef __cplusplus
 }
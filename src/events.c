@@ -0,0 +1,85 @@
+#include "events.h"
+#include "perf.h"
+
+static K_MSGQ_DEFINE(app_events, sizeof(struct app_event), APP_EVENT_QUEUE_LEN, 4);
+
+// time from app_event_post() until main() has handled the event and drawn the result
+static struct perf_stat latency[EVENT_TYPE_COUNT] = {
+    [EVENT_JOYSTICK] = { .name = "joystick->display" },
+    [EVENT_ROTATION] = { .name = "rotation->display" },
+    [EVENT_SWITCH] = { .name = "switch->display" },
+    [EVENT_KEY] = { .name = "key->display" },
+    [EVENT_TICK] = { .name = "tick->display" },
+    [EVENT_TIMEOUT] = { .name = "timeout->display" },
+    [EVENT_UI] = { .name = "ui timer->display" },
+};
+
+// time main() spends on one event, every other input waits in the queue meanwhile
+static PERF_STAT_DEFINE_HIRES(handling_stat, "event handling");
+static uint32_t handling_start;
+static uint32_t peak_depth;
+
+static uint32_t wakeups;
+static atomic_t dropped; // posts happen from ISRs
+static int64_t stats_since;
+
+// Safe from ISRs: never blocks, a full queue drops the event.
+// A producer that captured the input earlier passes its own timestamp,
+// otherwise the event is stamped here.
+int app_event_post(struct app_event *ev)
+{
+    if (ev->timestamp == 0) {
+        ev->timestamp = k_cycle_get_32();
+    }
+
+    int err = k_msgq_put(&app_events, ev, K_NO_WAIT);
+    if (err < 0) {
+        atomic_inc(&dropped);
+    }
+    return err;
+}
+
+int app_event_wait(struct app_event *ev, k_timeout_t timeout)
+{
+    int err = k_msgq_get(&app_events, ev, timeout);
+    if (err == 0) {
+        // events still queued behind this one
+        uint32_t depth = k_msgq_num_used_get(&app_events) + 1;
+
+        wakeups++;
+        peak_depth = MAX(peak_depth, depth);
+        handling_start = perf_start_hires();
+    }
+    return err;
+}
+
+// Called by the consumer once the event has been fully handled
+void app_event_done(const struct app_event *ev)
+{
+    perf_stop(&handling_stat, handling_start);
+    if (ev->type < EVENT_TYPE_COUNT) {
+        perf_stop(&latency[ev->type], ev->timestamp);
+    }
+}
+
+void app_event_print_stats(void)
+{
+#if PERF_ENABLED
+    int64_t now = k_uptime_get();
+    int64_t elapsed = MAX(now - stats_since, 1);
+
+    printk("[perf] events: %u wakeups in %lld ms (%u.%02u/s), %u dropped, peak depth %u\n",
+           wakeups, elapsed, (uint32_t)(wakeups * 1000 / elapsed),
+           (uint32_t)(wakeups * 100000 / elapsed % 100), (uint32_t)atomic_get(&dropped),
+           peak_depth);
+    perf_print(&handling_stat);
+    for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+        if (latency[i].count) {
+            perf_print(&latency[i]);
+        }
+    }
+
+    wakeups = 0;
+    stats_since = now;
+#endif
+}
\ No newline at end of file
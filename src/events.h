@@ -0,0 +1,39 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <zephyr/kernel.h>
+
+#include "gesture.h"
+
+// Events buffered between the producers (ISRs, timers, work items) and main()
+#define APP_EVENT_QUEUE_LEN 16
+
+enum app_event_type {
+    EVENT_JOYSTICK, // direction change from the joystick classifier
+    EVENT_ROTATION, // QDEC rotation since the last event, in selection steps
+    EVENT_SWITCH,   // encoder switch pressed, debounced
+    EVENT_KEY,      // HT16K33 keypad key pressed
+    EVENT_TICK,     // one second of the countdown elapsed
+    EVENT_TIMEOUT,  // the countdown ran out
+    EVENT_UI,       // a timed UI state ended
+    EVENT_TYPE_COUNT
+};
+
+struct app_event {
+    uint8_t type;
+    uint32_t timestamp; // k_cycle_get_32() of the input, 0 = stamped by app_event_post()
+    union {
+        struct gesture_event gesture;
+        int32_t rotation; // detents scaled by the acceleration curve, positive counts up
+        uint8_t ui;       // which UI timer expired, private to ui.c
+        int32_t remaining_ms; // countdown time left when the tick fired
+        int8_t key;       // keypad digit or KEYPAD_KEY_CLEAR
+    };
+};
+
+int app_event_post(struct app_event *ev);
+int app_event_wait(struct app_event *ev, k_timeout_t timeout);
+void app_event_done(const struct app_event *ev);
+void app_event_print_stats(void);
+
+#endif // EVENTS_H
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+// 5x7 font for printable ASCII, column-major: one byte per column, left to
+// right, bit 0 = top row. A string laid out column by column can be scrolled
+// by moving a pointer, see text.c.
+#define FONT_WIDTH 5
+#define FONT_HEIGHT 7
+#define FONT_SPACING 1 // blank column after every glyph
+#define FONT_FIRST ' '
+#define FONT_LAST '~'
+#define FONT_GLYPHS (FONT_LAST - FONT_FIRST + 1)
+
+extern const uint8_t font5x7[FONT_GLYPHS][FONT_WIDTH];
+
+// Glyph columns for c, characters outside the font map to '?'
+static inline const uint8_t *font_glyph(char c)
+{
+    if (c < FONT_FIRST || c > FONT_LAST) {
+        c = '?';
+    }
+    return font5x7[c - FONT_FIRST];
+}
+
+#endif // FONT_H
\ No newline at end of file
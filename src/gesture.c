@@ -0,0 +1,58 @@
+#include <stdlib.h>
+
+#include "gesture.h"
+
+void gesture_init(struct gesture *g, const struct gesture_config *cfg)
+{
+    g->cfg = *cfg;
+    g->state = GESTURE_NONE; // must see the center once before the first entry
+    g->candidate = GESTURE_NONE;
+    g->candidate_since = 0;
+}
+
+static enum gesture_dir dominant_dir(int16_t x, int16_t y)
+{
+    if (abs(x) >= abs(y)) {
+        return x >= 0 ? GESTURE_RIGHT : GESTURE_LEFT;
+    }
+    return y >= 0 ? GESTURE_UP : GESTURE_DOWN;
+}
+
+// Classify one sample in constant time. Returns true and fills ev when the
+// reported state changes.
+bool gesture_feed(struct gesture *g, int16_t x, int16_t y, uint32_t now_ms, struct gesture_event *ev)
+{
+    int16_t mag = abs(x) > abs(y) ? abs(x) : abs(y);
+    enum gesture_dir zone;
+
+    if (mag >= g->cfg.deadzone + g->cfg.hysteresis) {
+        zone = dominant_dir(x, y);
+    } else if (mag <= g->cfg.deadzone - g->cfg.hysteresis) {
+        zone = GESTURE_CENTER;
+    } else {
+        zone = g->state; // inside the hysteresis band nothing changes
+    }
+
+    if (zone == g->state) {
+        g->candidate = GESTURE_NONE;
+        return false;
+    }
+
+    if (zone != g->candidate) {
+        g->candidate = zone;
+        g->candidate_since = now_ms;
+        return false;
+    }
+
+    if (now_ms - g->candidate_since < g->cfg.dwell_ms) {
+        return false;
+    }
+
+    ev->dir = zone;
+    ev->entry = (g->state == GESTURE_CENTER && zone != GESTURE_CENTER);
+    ev->timestamp = now_ms;
+
+    g->state = zone;
+    g->candidate = GESTURE_NONE;
+    return true;
+}
\ No newline at end of file
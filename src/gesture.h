@@ -0,0 +1,47 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Joystick direction classifier. Plain C without kernel dependencies so it can
+// be built on the host and fed recorded joystick traces.
+
+// Defaults, in joystick vector units (full deflection = 1024)
+#define GESTURE_DEADZONE 384
+#define GESTURE_HYSTERESIS 128
+#define GESTURE_DWELL_MS 30
+
+// Direction values are the digits stored in the joystick password
+enum gesture_dir {
+    GESTURE_NONE = 0,
+    GESTURE_UP = 1,
+    GESTURE_RIGHT = 2,
+    GESTURE_DOWN = 3,
+    GESTURE_LEFT = 4,
+    GESTURE_CENTER = 5,
+};
+
+struct gesture_config {
+    int16_t deadzone;   // deflection separating center from a direction
+    int16_t hysteresis; // enter above deadzone + hysteresis, leave below deadzone - hysteresis
+    uint32_t dwell_ms;  // a new state must hold this long before it is reported
+};
+
+struct gesture_event {
+    enum gesture_dir dir;
+    bool entry;         // direction reached straight from center: counts as password input
+    uint32_t timestamp; // ms, as passed to gesture_feed()
+};
+
+struct gesture {
+    struct gesture_config cfg;
+    enum gesture_dir state;     // last reported state
+    enum gesture_dir candidate; // state waiting for its dwell time
+    uint32_t candidate_since;
+};
+
+void gesture_init(struct gesture *g, const struct gesture_config *cfg);
+bool gesture_feed(struct gesture *g, int16_t x, int16_t y, uint32_t now_ms, struct gesture_event *ev);
+
+#endif // GESTURE_H
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/sys/printk.h>
+
+#include "i2c_queue.h"
+#include "led.h"
+#include "perf.h"
+
+RTIO_DEFINE(i2c_rtio, I2C_QUEUE_BATCH, I2C_QUEUE_BATCH);
+
+struct i2c_queue_req {
+    const struct rtio_iodev *iodev;
+    const uint8_t *buf;
+    size_t len;
+    i2c_queue_done_t done;
+    void *user_data;
+    uint32_t queued; // k_cycle_get_32() at i2c_queue_write()
+};
+
+// Per priority ring, filled by any thread and drained by the bus thread
+struct i2c_queue_lane {
+    struct i2c_queue_req req[I2C_QUEUE_DEPTH];
+    uint8_t head;
+    uint8_t count;
+};
+
+static struct i2c_queue_lane lanes[I2C_QUEUE_PRIO_COUNT];
+static struct k_spinlock lock;
+static K_SEM_DEFINE(pending, 0, K_SEM_MAX_LIMIT);
+
+static const uint8_t rtio_prio[I2C_QUEUE_PRIO_COUNT] = {
+    [I2C_QUEUE_PRIO_CONTROL] = RTIO_PRIO_HIGH,
+    [I2C_QUEUE_PRIO_REDRAW] = RTIO_PRIO_LOW,
+};
+
+// time from i2c_queue_write() until the bus thread picked the request up
+static struct perf_stat wait_stat[I2C_QUEUE_PRIO_COUNT] = {
+    [I2C_QUEUE_PRIO_CONTROL] = { .name = "i2c wait control" },
+    [I2C_QUEUE_PRIO_REDRAW] = { .name = "i2c wait redraw" },
+};
+static PERF_STAT_DEFINE(batch_stat, "i2c batch");
+static uint32_t transactions, batches, max_batch, bytes, failures;
+
+int i2c_queue_write(const struct rtio_iodev *iodev, enum i2c_queue_prio prio, const uint8_t *buf,
+                    size_t len, i2c_queue_done_t done, void *user_data)
+{
+    struct i2c_queue_lane *lane = &lanes[prio];
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (lane->count == I2C_QUEUE_DEPTH) {
+        k_spin_unlock(&lock, key);
+        return -ENOMEM;
+    }
+
+    lane->req[(lane->head + lane->count) % I2C_QUEUE_DEPTH] = (struct i2c_queue_req){
+        .iodev = iodev,
+        .buf = buf,
+        .len = len,
+        .done = done,
+        .user_data = user_data,
+        .queued = perf_start(),
+    };
+    lane->count++;
+    k_spin_unlock(&lock, key);
+
+    k_sem_give(&pending);
+    return 0;
+}
+
+// Oldest request of the most urgent non-empty lane
+static bool next_request(struct i2c_queue_req *req, enum i2c_queue_prio *prio)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (int p = 0; p < I2C_QUEUE_PRIO_COUNT; p++) {
+        struct i2c_queue_lane *lane = &lanes[p];
+
+        if (lane->count) {
+            *req = lane->req[lane->head];
+            *prio = p;
+            lane->head = (lane->head + 1) % I2C_QUEUE_DEPTH;
+            lane->count--;
+            k_spin_unlock(&lock, key);
+            return true;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+    return false;
+}
+
+static void i2c_queue_thread(void *p1, void *p2, void *p3)
+{
+    struct i2c_queue_req batch[I2C_QUEUE_BATCH];
+    enum i2c_queue_prio prio;
+
+    while (1) {
+        k_sem_take(&pending, K_FOREVER);
+
+        // the queued control commands and the next redraws go out back to
+        // back, without a thread round trip between the transactions
+        uint32_t n = 0;
+        uint32_t redraws = 0;
+
+        while (n < I2C_QUEUE_BATCH && redraws < I2C_QUEUE_REDRAW_BATCH &&
+               next_request(&batch[n], &prio)) {
+            struct rtio_sqe *sqe = rtio_sqe_acquire(&i2c_rtio);
+
+            perf_stop(&wait_stat[prio], batch[n].queued);
+            rtio_sqe_prep_write(sqe, batch[n].iodev, rtio_prio[prio], (uint8_t *)batch[n].buf,
+                                batch[n].len, &batch[n]);
+            sqe->iodev_flags |= RTIO_IODEV_I2C_STOP;
+            if (n > 0) {
+                (void)k_sem_take(&pending, K_NO_WAIT); // one count per request
+            }
+            if (prio == I2C_QUEUE_PRIO_REDRAW) {
+                redraws++;
+            }
+            n++;
+        }
+
+        if (n == 0) {
+            continue;
+        }
+
+        // sleeps until every transaction of the batch has completed
+        uint32_t start = perf_start();
+        int err = rtio_submit(&i2c_rtio, n);
+        perf_stop(&batch_stat, start);
+
+        batches++;
+        max_batch = MAX(max_batch, n);
+
+        for (uint32_t i = 0; i < n; i++) {
+            struct rtio_cqe *cqe = rtio_cqe_consume(&i2c_rtio);
+            struct i2c_queue_req *req = cqe ? cqe->userdata : &batch[i];
+            int result = cqe ? cqe->result : err;
+
+            if (cqe) {
+                rtio_cqe_release(&i2c_rtio, cqe);
+            }
+
+            transactions++;
+            bytes += req->len;
+            if (result < 0) {
+                failures++;
+            }
+
+            if (req->done) {
+                req->done(result, req->user_data);
+            }
+        }
+    }
+}
+
+K_THREAD_DEFINE(i2c_queue_tid, I2C_QUEUE_STACK_SIZE, i2c_queue_thread, NULL, NULL, NULL,
+                I2C_QUEUE_PRIORITY, 0, 0);
+
+// Running totals since boot, for callers that measure their own share of the bus
+void i2c_queue_get_totals(uint32_t *transactions_out, uint32_t *bytes_out)
+{
+    *transactions_out = transactions;
+    *bytes_out = bytes;
+}
+
+void i2c_queue_print_stats(void)
+{
+#if PERF_ENABLED
+    // totals are kept since boot
+    int64_t elapsed = MAX(k_uptime_get(), 1);
+
+    printk("[perf] i2c0: %u transactions (%u.%02u/s) in %u batches (max %u), %u bytes, "
+           "%u failed, %u Hz\n", transactions,
+           (uint32_t)((uint64_t)transactions * 1000 / elapsed),
+           (uint32_t)((uint64_t)transactions * 100000 / elapsed % 100), batches, max_batch, bytes,
+           failures, DT_PROP(DT_BUS(LED_NODE), clock_frequency));
+    for (int p = 0; p < I2C_QUEUE_PRIO_COUNT; p++) {
+        perf_print(&wait_stat[p]);
+    }
+    perf_print(&batch_stat);
+#endif
+}
\ No newline at end of file
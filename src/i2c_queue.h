@@ -0,0 +1,40 @@
+#ifndef I2C_QUEUE_H
+#define I2C_QUEUE_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+
+// Asynchronous transaction queue for the HT16K33 panels on i2c0, executed
+// through RTIO. Callers hand over a request and return at once; one bus thread
+// submits the pending control commands and at most I2C_QUEUE_REDRAW_BATCH frame
+// redraws as one batch, and sleeps until the whole batch has completed.
+
+#define I2C_QUEUE_DEPTH 8 // requests waiting per priority
+#define I2C_QUEUE_BATCH 8 // requests submitted to RTIO in one go
+#define I2C_QUEUE_STACK_SIZE 768
+
+// The HT16K33 keyscan reads come from the driver thread, outside this queue.
+// A read issued during a batch waits until the batch is done, so a batch
+// carries at most this many frame writes, ~0.5 ms each at 400 kHz.
+#define I2C_QUEUE_REDRAW_BATCH 1
+
+// Lowest application priority, so a keyscan read that is waiting gets the bus
+// before the next batch is submitted.
+#define I2C_QUEUE_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+enum i2c_queue_prio {
+    I2C_QUEUE_PRIO_CONTROL, // setup, dimming and blink commands, a few bytes each
+    I2C_QUEUE_PRIO_REDRAW,  // display RAM writes, coalesced by the caller
+    I2C_QUEUE_PRIO_COUNT
+};
+
+// Runs in the bus thread once the transfer has finished
+typedef void (*i2c_queue_done_t)(int result, void *user_data);
+
+// buf must stay untouched until done is called
+int i2c_queue_write(const struct rtio_iodev *iodev, enum i2c_queue_prio prio, const uint8_t *buf,
+                    size_t len, i2c_queue_done_t done, void *user_data);
+void i2c_queue_get_totals(uint32_t *transactions, uint32_t *bytes);
+void i2c_queue_print_stats(void);
+
+#endif // I2C_QUEUE_H
\ No newline at end of file
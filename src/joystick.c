@@ -0,0 +1,333 @@
+#include <zephyr/devicetree.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+#include "joystick.h"
+#include "events.h"
+#include "telemetry.h"
+
+LOG_MODULE_REGISTER(joystick, CONFIG_SAFE_JOYSTICK_LOG_LEVEL);
+
+#if !DT_NODE_EXISTS(DT_PATH(zephyr_user)) || \
+    !DT_NODE_HAS_PROP(DT_PATH(zephyr_user), io_channels)
+#error "No suitable devicetree overlay specified"
+#endif
+
+#define DT_SPEC_AND_COMMA(node_id, prop, idx) \
+    ADC_DT_SPEC_GET_BY_IDX(node_id, idx),
+
+/* Data of ADC io-channels specified in devicetree. */
+static const struct adc_dt_spec adc_channels[] = {
+    DT_FOREACH_PROP_ELEM(DT_PATH(zephyr_user), io_channels,
+                 DT_SPEC_AND_COMMA)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(adc_channels) == 2, "joystick needs exactly two io-channels (X, Y)");
+
+#define CENTER_SAMPLES 16
+#define CAL_SAVE_DELAY K_SECONDS(5)
+
+// One scan fills both channels, in ascending channel order: AIN1 (X), AIN2 (Y)
+static int16_t scan_buf[2];
+static struct adc_sequence sequence = {
+    .buffer = scan_buf,
+    /* buffer size in bytes, not number of samples */
+    .buffer_size = sizeof(scan_buf),
+};
+
+// Median of the last three samples followed by a first-order IIR, in Q4 fixed point
+struct axis_filter {
+    int16_t hist[3];
+    uint8_t pos;
+    bool primed;
+    int32_t iir_q4;
+};
+
+static struct axis_filter filter_x, filter_y;
+static int32_t sum_x, sum_y;
+static uint8_t sum_count;
+
+static atomic_t running;
+static atomic_t stop_request;
+
+// Classified in the ADC callback at the filtered sample rate
+static struct gesture gesture;
+
+// Used by the ADC interrupt, replaced from the settings loader and at boot,
+// so every access holds cal_lock
+static int16_t center_x, center_y;
+static struct joystick_extents ext = {
+    JOYSTICK_MIN_EXTENT, JOYSTICK_MIN_EXTENT, JOYSTICK_MIN_EXTENT, JOYSTICK_MIN_EXTENT,
+};
+static struct k_spinlock cal_lock;
+
+static void cal_save_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(cal_save_work, cal_save_handler);
+
+// Stored extents only ever widen the ones in use
+static int joystick_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    struct joystick_extents stored;
+
+    if (settings_name_steq(name, "ext", &next) && !next) {
+        if (len != sizeof(stored) || read_cb(cb_arg, &stored, sizeof(stored)) != sizeof(stored)) {
+            return -EINVAL;
+        }
+
+        k_spinlock_key_t key = k_spin_lock(&cal_lock);
+
+        ext.left = MAX(ext.left, stored.left);
+        ext.right = MAX(ext.right, stored.right);
+        ext.down = MAX(ext.down, stored.down);
+        ext.up = MAX(ext.up, stored.up);
+        k_spin_unlock(&cal_lock, key);
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(joystick, "joy", NULL, joystick_settings_set, NULL, NULL);
+
+static void cal_save_handler(struct k_work *work)
+{
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    struct joystick_extents saved = ext;
+
+    k_spin_unlock(&cal_lock, key);
+
+    int err = settings_save_one("joy/ext", &saved, sizeof(saved));
+    if (err < 0) {
+        LOG_ERR("Could not save joystick extents (%d)", err);
+    }
+}
+
+static void learn_extents(const struct joystick_sample *sample);
+static void scale_sample(const struct joystick_sample *sample, struct joystick_vec *vec);
+
+static int16_t median3(int16_t a, int16_t b, int16_t c)
+{
+    return MAX(MIN(a, b), MIN(MAX(a, b), c));
+}
+
+static int16_t axis_filter_step(struct axis_filter *f, int16_t raw)
+{
+    if (!f->primed) {
+        f->hist[0] = f->hist[1] = f->hist[2] = raw;
+        f->iir_q4 = raw << 4;
+        f->primed = true;
+    }
+
+    f->hist[f->pos] = raw;
+    f->pos = (f->pos == 2) ? 0 : f->pos + 1;
+
+    int16_t med = median3(f->hist[0], f->hist[1], f->hist[2]);
+    f->iir_q4 += ((med << 4) - f->iir_q4) >> JOYSTICK_IIR_SHIFT;
+
+    return f->iir_q4 >> 4;
+}
+
+int joystick_init(void)
+{
+    int err;
+
+    /* Configure channels individually prior to sampling. */
+    for (size_t i = 0U; i < ARRAY_SIZE(adc_channels); i++) {
+        if (!adc_is_ready_dt(&adc_channels[i])) {
+            LOG_ERR("ADC controller device %s not ready", adc_channels[i].dev->name);
+            return -1;
+        }
+
+        err = adc_channel_setup_dt(&adc_channels[i]);
+        if (err < 0) {
+            LOG_ERR("Could not setup channel #%d (%d)", i, err);
+            return -1;
+        }
+    }
+
+    // a single sequence covering both channels
+    (void)adc_sequence_init_dt(&adc_channels[0], &sequence);
+    sequence.channels |= BIT(adc_channels[1].channel_id);
+
+    // SAADC offset self-calibration runs together with the first scan
+    struct joystick_sample sample;
+
+    sequence.calibrate = true;
+    err = joystick_read(&sample);
+    sequence.calibrate = false;
+    if (err < 0) {
+        LOG_ERR("Joystick calibration scan failed (%d)", err);
+        return -1;
+    }
+
+    // the stored extents load in the background after Bluetooth is up and
+    // apply around this center
+    if (joystick_recalibrate() < 0) {
+        LOG_ERR("Joystick center measurement failed");
+        return -1;
+    }
+
+    LOG_INF("Joystick center %d,%d", center_x, center_y);
+    return 0;
+}
+
+// Take the current stick position as center, the learned extents are kept.
+// The stick must be at rest and continuous mode off.
+int joystick_recalibrate(void)
+{
+    struct joystick_sample sample;
+    int32_t cx = 0, cy = 0;
+
+    for (int i = 0; i < CENTER_SAMPLES; i++) {
+        int err = joystick_read(&sample);
+        if (err < 0) {
+            return err;
+        }
+        cx += sample.x;
+        cy += sample.y;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+
+    center_x = cx / CENTER_SAMPLES;
+    center_y = cy / CENTER_SAMPLES;
+    k_spin_unlock(&cal_lock, key);
+    return 0;
+}
+
+// One blocking scan of both axes, only usable while continuous mode is off
+int joystick_read(struct joystick_sample *sample)
+{
+    if (atomic_get(&running)) {
+        return -EBUSY;
+    }
+
+    sequence.options = NULL;
+    int err = adc_read(adc_channels[0].dev, &sequence);
+    if (err < 0) {
+        return err;
+    }
+
+    // single-ended inputs can read slightly below 0 V
+    sample->x = MAX(scan_buf[0], 0);
+    sample->y = MAX(scan_buf[1], 0);
+    sample->timestamp = k_cycle_get_32();
+    return 0;
+}
+
+// Runs in the SAADC interrupt after every scan
+static enum adc_action sample_done(const struct device *dev, const struct adc_sequence *seq,
+                                   uint16_t sampling_index)
+{
+    sum_x += MAX(scan_buf[0], 0);
+    sum_y += MAX(scan_buf[1], 0);
+
+    if (++sum_count == JOYSTICK_OVERSAMPLING) {
+        struct joystick_sample sample;
+
+        telemetry_record(TELEMETRY_SRC_JOYSTICK, sum_x / JOYSTICK_OVERSAMPLING,
+                         sum_y / JOYSTICK_OVERSAMPLING);
+        sample.x = axis_filter_step(&filter_x, sum_x / JOYSTICK_OVERSAMPLING);
+        sample.y = axis_filter_step(&filter_y, sum_y / JOYSTICK_OVERSAMPLING);
+        sample.timestamp = k_cycle_get_32();
+
+        struct joystick_vec vec;
+        struct app_event ev = { .type = EVENT_JOYSTICK };
+
+        k_spinlock_key_t key = k_spin_lock(&cal_lock);
+
+        learn_extents(&sample);
+        scale_sample(&sample, &vec);
+        k_spin_unlock(&cal_lock, key);
+        if (gesture_feed(&gesture, vec.x, vec.y, k_uptime_get_32(), &ev.gesture)) {
+            // a full queue drops the event rather than stalling the ADC
+            (void)app_event_post(&ev);
+        }
+
+        sum_x = 0;
+        sum_y = 0;
+        sum_count = 0;
+    }
+
+    if (atomic_get(&stop_request)) {
+        atomic_clear(&running);
+        return ADC_ACTION_FINISH;
+    }
+
+    // sample the same buffer again after interval_us, forever
+    return ADC_ACTION_REPEAT;
+}
+
+static const struct adc_sequence_options continuous_options = {
+    .interval_us = JOYSTICK_SAMPLE_INTERVAL_US,
+    .callback = sample_done,
+};
+
+int joystick_start(void)
+{
+    if (atomic_set(&running, 1)) {
+        return 0;
+    }
+
+    atomic_clear(&stop_request);
+    gesture_init(&gesture, &(struct gesture_config){
+        .deadzone = GESTURE_DEADZONE,
+        .hysteresis = GESTURE_HYSTERESIS,
+        .dwell_ms = GESTURE_DWELL_MS,
+    });
+    sequence.options = &continuous_options;
+
+    int err = adc_read_async(adc_channels[0].dev, &sequence, NULL);
+    if (err < 0) {
+        LOG_ERR("Could not start joystick sampling (%d)", err);
+        atomic_clear(&running);
+    }
+    return err;
+}
+
+void joystick_stop(void)
+{
+    atomic_set(&stop_request, 1);
+}
+
+// Readings past a learned extent widen it, cal_lock held
+static void learn_extent(int16_t raw, int16_t center, int16_t *neg, int16_t *pos)
+{
+    int16_t d = raw - center;
+
+    if (d > *pos) {
+        *pos = d;
+        k_work_reschedule(&cal_save_work, CAL_SAVE_DELAY);
+    } else if (-d > *neg) {
+        *neg = -d;
+        k_work_reschedule(&cal_save_work, CAL_SAVE_DELAY);
+    }
+}
+
+static void learn_extents(const struct joystick_sample *sample)
+{
+    learn_extent(sample->x, center_x, &ext.left, &ext.right);
+    learn_extent(sample->y, center_y, &ext.down, &ext.up);
+}
+
+// Map one axis onto -JOYSTICK_VEC_MAX..JOYSTICK_VEC_MAX using separate extents
+// on each side of the center
+static int16_t scale_axis(int16_t raw, int16_t center, int16_t neg, int16_t pos)
+{
+    int32_t d = raw - center;
+
+    if (d >= 0) {
+        return MIN((d * JOYSTICK_VEC_MAX) / MAX(pos, 1), JOYSTICK_VEC_MAX);
+    }
+    return MAX((d * JOYSTICK_VEC_MAX) / MAX(neg, 1), -JOYSTICK_VEC_MAX);
+}
+
+// cal_lock held
+static void scale_sample(const struct joystick_sample *sample, struct joystick_vec *vec)
+{
+    vec->x = scale_axis(sample->x, center_x, ext.left, ext.right);
+    vec->y = scale_axis(sample->y, center_y, ext.down, ext.up);
+    vec->timestamp = sample->timestamp;
+}
\ No newline at end of file
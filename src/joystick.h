@@ -0,0 +1,55 @@
+#ifndef JOYSTICK_H
+#define JOYSTICK_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/adc.h>
+
+#include "gesture.h"
+
+// SAADC scan period of both joystick axes
+#define JOYSTICK_SAMPLE_INTERVAL_US 250
+
+// Scans averaged into one filtered sample (software oversampling)
+#define JOYSTICK_OVERSAMPLING 4
+
+// IIR smoothing factor: y += (x - y) >> JOYSTICK_IIR_SHIFT
+#define JOYSTICK_IIR_SHIFT 2
+
+// Full deflection of the calibrated vector on each axis
+#define JOYSTICK_VEC_MAX 1024
+
+// Smallest deflection (raw counts) assumed before the extents have been learned
+#define JOYSTICK_MIN_EXTENT 600
+
+// X and Y taken in the same SAADC scan
+struct joystick_sample {
+    int16_t x;
+    int16_t y;
+    uint32_t timestamp; // k_cycle_get_32() when the scan finished
+};
+
+// Calibrated deflection, -JOYSTICK_VEC_MAX..JOYSTICK_VEC_MAX, 0 = stick at rest.
+// +x is right, +y is up.
+struct joystick_vec {
+    int16_t x;
+    int16_t y;
+    uint32_t timestamp;
+};
+
+// Learned deflection in raw counts on each side of the center, persisted under
+// the "joy/ext" settings key. The center itself drifts as the stick ages and
+// is measured again at every boot.
+struct joystick_extents {
+    int16_t left;
+    int16_t right;
+    int16_t down;
+    int16_t up;
+};
+
+int joystick_init(void);
+int joystick_read(struct joystick_sample *sample);
+int joystick_start(void);
+void joystick_stop(void);
+int joystick_recalibrate(void);
+
+#endif // JOYSTICK_H
\ No newline at end of file
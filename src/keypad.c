@@ -0,0 +1,75 @@
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include "keypad.h"
+#include "events.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(keypad, CONFIG_SAFE_KEYPAD_LOG_LEVEL);
+
+#define I2C_BUS_HZ DT_PROP(DT_BUS(LED_NODE), clock_frequency)
+
+// One keyscan read by the driver: address + register write, repeated start,
+// address + 6 bytes of key RAM, each byte 9 clocks with the ACK, plus
+// start/restart/stop
+#define KEYSCAN_READ_BITS (9 * (2 + 1 + 6) + 3)
+#define KEYSCAN_READ_US (KEYSCAN_READ_BITS * 1000000U / I2C_BUS_HZ)
+
+static const struct device *const keyscan = DEVICE_DT_GET(KEY_NODE);
+
+static const int8_t keymap[KEYPAD_ROWS][KEYPAD_COLUMNS] = { KEYPAD_KEYMAP };
+
+static uint32_t key_presses;
+
+// Runs in the HT16K33 driver thread after the INT line reported a key change
+static void keypad_callback(const struct device *dev, uint32_t row, uint32_t column, bool pressed)
+{
+    if (!pressed || row >= KEYPAD_ROWS || column >= KEYPAD_COLUMNS) {
+        return;
+    }
+
+    int8_t key = keymap[row][column];
+    if (key == KEYPAD_KEY_NONE) {
+        return;
+    }
+
+    struct app_event ev = { .type = EVENT_KEY, .key = key };
+
+    key_presses++;
+    app_event_post(&ev);
+}
+
+int keypad_init(void)
+{
+    if (!device_is_ready(keyscan)) {
+        LOG_ERR("Keyscan device is not ready");
+        return -1;
+    }
+
+    int err = kscan_config(keyscan, keypad_callback);
+    if (err < 0) {
+        LOG_ERR("Could not configure keyscan (%d)", err);
+        return -1;
+    }
+
+    err = kscan_enable_callback(keyscan);
+    if (err < 0) {
+        LOG_ERR("Could not enable keyscan callback (%d)", err);
+        return -1;
+    }
+    return 0;
+}
+
+// With irq-gpios the driver reads key RAM only while a key is held. Without
+// it, every CONFIG_HT16K33_KEYSCAN_POLL_MSEC took the bus for one read.
+void keypad_print_stats(void)
+{
+#if PERF_ENABLED
+    uint32_t polls = k_uptime_get() / CONFIG_HT16K33_KEYSCAN_POLL_MSEC;
+
+    printk("[perf] keypad: %u keys, %u idle scan reads avoided (%u us each, %u ms of i2c0)\n",
+           key_presses, polls, KEYSCAN_READ_US, polls * KEYSCAN_READ_US / 1000U);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+
+#include "led.h"
+
+#if !DT_NODE_HAS_PROP(LED_NODE, irq_gpios)
+#error "HT16K33 irq-gpios is required, the keypad is not polled"
+#endif
+
+#define KEYPAD_ROWS 3 // KS0..KS2
+#define KEYPAD_COLUMNS 4 // K1..K4 used
+
+#define KEYPAD_KEY_NONE -1
+#define KEYPAD_KEY_CLEAR -2
+
+// Key value per HT16K33 row and column, as wired on the keypad: digits 0..9,
+// KEYPAD_KEY_CLEAR drops the digits entered so far.
+#define KEYPAD_KEYMAP \
+    { 1, 2, 3, KEYPAD_KEY_CLEAR }, \
+    { 4, 5, 6, KEYPAD_KEY_NONE }, \
+    { 7, 8, 9, 0 }
+
+int keypad_init(void);
+void keypad_print_stats(void);
+
+#endif // KEYPAD_H
\ No newline at end of file
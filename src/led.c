@@ -1,171 +1,547 @@
+#include <string.h>
+#include <zephyr/logging/log.h>
+
 #include "led.h"
+#include "i2c_queue.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(led, CONFIG_SAFE_LED_LOG_LEVEL);
 
-const uint8_t led_patterns[10][8] = {
-    {0b11111111, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b11111111}, // 0
-    {0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000}, // 1
-    {0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b00000000}, // 2
-    {0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000}, // 3
-    {0b10000001, 0b10000001, 0b10000001, 0b11111111, 0b00000001, 0b00000001, 0b00000001, 0b00000000}, // 4
-    {0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000}, // 5
-    {0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000000}, // 6
-    {0b11111111, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000000}, // 7
-    {0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000000}, // 8
-    {0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000}  // 9
+// Every enabled HT16K33 is one panel. The panel at LED_PANEL_BASE_ADDR + n
+// covers canvas columns 16n..16n+15.
+struct led_panel {
+    const struct device *dev;
+    const struct rtio_iodev *iodev;
 };
 
+#define PANEL_INDEX(node_id) (DT_REG_ADDR(node_id) - LED_PANEL_BASE_ADDR)
+#define PANEL_IODEV(node_id) UTIL_CAT(panel_iodev_, DT_DEP_ORD(node_id))
+#define PANEL_IODEV_DEFINE_(name, node_id) I2C_DT_IODEV_DEFINE(name, node_id);
+#define PANEL_IODEV_DEFINE(node_id) PANEL_IODEV_DEFINE_(PANEL_IODEV(node_id), node_id)
+#define PANEL_CHECK(node_id) \
+    BUILD_ASSERT(PANEL_INDEX(node_id) < LED_PANEL_COUNT, \
+                 "HT16K33 panels must use consecutive addresses from 0x70");
+#define PANEL_ENTRY(node_id) \
+    [PANEL_INDEX(node_id)] = { .dev = DEVICE_DT_GET(node_id), .iodev = &PANEL_IODEV(node_id) },
+
+DT_FOREACH_STATUS_OKAY(holtek_ht16k33, PANEL_IODEV_DEFINE)
+DT_FOREACH_STATUS_OKAY(holtek_ht16k33, PANEL_CHECK)
 
-const uint8_t password_success[8] = { // when password get success (smile face)
-    0b00000000, 
-    0b01000010, 
-    0b10100101, 
-    0b00000000, 
-    0b00000000, 
-    0b01000010, 
-    0b00111100, 
-    0b00000000
+static const struct led_panel panels[LED_PANEL_COUNT] = {
+    DT_FOREACH_STATUS_OKAY(holtek_ht16k33, PANEL_ENTRY)
 };
 
-const uint8_t password_unsuccess[8] = { // when password fail (crying face)
-    0b00000000, 
-    0b10100101, 
-    0b01000010, 
-    0b00000000, 
-    0b00000000, 
-    0b00111100, 
-    0b01000010, 
-    0b00000000
+// RAM shadow of the HT16K33 display memories. Drawing only touches this copy,
+// led_flush() pushes the dirty rows of each panel in one auto-increment burst.
+// The shadow is shared with the I2C queue thread, which starts the next
+// coalesced flush, so every access holds fb_lock.
+static uint8_t frame[LED_PANEL_COUNT][LED_RAM_SIZE];
+static uint8_t dirty_rows[LED_PANEL_COUNT]; // bit n set: row n differs from the chip
+static bool blank_swap; // led_off_all() defers the blank to the next flush
+static struct k_spinlock fb_lock;
+
+// One pass queues one burst per dirty panel. The I2C queue submits every burst
+// as its own RTIO batch (I2C_QUEUE_REDRAW_BATCH), so a pass costs one bus round
+// trip per panel and the frame time grows linearly with the panel count.
+// Flushes requested while a pass is on the bus only leave their rows dirty and
+// go out together when it completes.
+static uint8_t tx_buf[LED_PANEL_COUNT][1 + LED_RAM_SIZE];
+static uint8_t flush_outstanding; // panel writes of the current pass still on the bus
+static bool flush_failed;
+static uint32_t flush_start; // perf_start() of the oldest flush in the current pass
+static bool flush_pending; // led_flush() called while the pass was on the bus
+static uint32_t flush_requested; // perf_start() of the oldest of those, stat only
+static uint32_t flushes, panel_writes, coalesced;
+static K_SEM_DEFINE(flush_idle, 0, 1);
+
+// Chip-wide commands, sent to every panel. While one is on the bus a new value
+// only replaces cmd, the last completion resends it, so the latest value wins.
+#define HT16K33_CMD_DISPLAY_SETUP 0x80
+#define HT16K33_DISPLAY_ON BIT(0)
+#define HT16K33_CMD_DIMMING 0xE0
+
+// Set from the main thread and the animation work item, so like the frame
+// state every field is only touched with fb_lock held
+struct led_command {
+    uint8_t cmd;  // latest requested value
+    uint8_t sent; // value on the bus, the buffer every panel write points at
+    uint8_t outstanding; // panels the queued command has not reached yet
+};
+
+static struct led_command dim_command = { .cmd = HT16K33_CMD_DIMMING | 15 };
+static struct led_command blink_command = { .cmd = HT16K33_CMD_DISPLAY_SETUP | HT16K33_DISPLAY_ON };
+static uint32_t commands_sent;
+
+// led_flush() call until the rows are on the chip
+static PERF_STAT_DEFINE(flush_stat, "led_flush");
+
+// Compile-time encoding of the sprite atlas into HT16K33 RAM images.
+// RAM byte 2*row holds the left half, 2*row+1 the right half, bit 0 = leftmost column.
+#define REV8(b) ((uint8_t)((((b) & 0x01) << 7) | (((b) & 0x02) << 5) | (((b) & 0x04) << 3) | \
+                           (((b) & 0x08) << 1) | (((b) & 0x10) >> 1) | (((b) & 0x20) >> 3) | \
+                           (((b) & 0x40) >> 5) | (((b) & 0x80) >> 7)))
+#define L8(r) REV8(r), 0
+#define R8(r) 0, REV8(r)
+#define W16(r) REV8((r) >> 8), REV8((r) & 0xFF)
+
+struct led_sprite {
+    uint8_t ram[2][LED_RAM_SIZE]; // image placed on the LEFT / RIGHT half
+    bool wide; // covers both halves, only ram[LEFT] is used
 };
 
+#define SPRITE_8_IMAGE(name, r0, r1, r2, r3, r4, r5, r6, r7) \
+    [SPRITE_##name] = { .ram = { { L8(r0), L8(r1), L8(r2), L8(r3), L8(r4), L8(r5), L8(r6), L8(r7) }, \
+                                 { R8(r0), R8(r1), R8(r2), R8(r3), R8(r4), R8(r5), R8(r6), R8(r7) } } },
+#define SPRITE_16_IMAGE(name, r0, r1, r2, r3, r4, r5, r6, r7) \
+    [SPRITE_##name] = { .ram = { { W16(r0), W16(r1), W16(r2), W16(r3), W16(r4), W16(r5), W16(r6), W16(r7) } }, \
+                        .wide = true },
+
+static const struct led_sprite sprites[SPRITE_COUNT] = {
+    LED_SPRITES(SPRITE_8_IMAGE, SPRITE_16_IMAGE)
+};
+
+// Which RAM bytes a sprite owns: LEFT half, RIGHT half, whole matrix
+static const uint8_t sprite_masks[3][LED_RAM_SIZE] = {
+    { L8(0xFF), L8(0xFF), L8(0xFF), L8(0xFF), L8(0xFF), L8(0xFF), L8(0xFF), L8(0xFF) },
+    { R8(0xFF), R8(0xFF), R8(0xFF), R8(0xFF), R8(0xFF), R8(0xFF), R8(0xFF), R8(0xFF) },
+    { W16(0xFFFF), W16(0xFFFF), W16(0xFFFF), W16(0xFFFF), W16(0xFFFF), W16(0xFFFF), W16(0xFFFF), W16(0xFFFF) },
+};
+#define MASK_WIDE 2
+
 int led_init(void)
 {
-    if (!device_is_ready(led)) {
-        printk("LED device %s is not ready\n", led->name);
-        return -1;
+    for (int p = 0; p < LED_PANEL_COUNT; p++) {
+        if (!device_is_ready(panels[p].dev)) {
+            LOG_ERR("LED panel %d (%s) is not ready", p, panels[p].dev->name);
+            return -1;
+        }
+
+        // the chip's RAM content is unknown after reset, sync it on the first flush
+        dirty_rows[p] = BIT_MASK(LED_ROWS);
     }
-    return 0;
-}
 
-void led_off_all(void)
-{
-    for (int i = 0; i < MAX_LED_NUM; i++) {
-        if (led_off(led, i) < 0) {
-            printk("Failed to turn off LED %d\n", i);
-        }
+    LOG_INF("LED canvas %dx%d on %d panel(s)", LED_CANVAS_WIDTH, LED_CANVAS_HEIGHT,
+            LED_PANEL_COUNT);
+
+    int err = led_flush();
+    if (err < 0) {
+        return err;
     }
+    return led_flush_wait(K_MSEC(100));
 }
 
-void led_on_idx(int idx, bool left_right)
+// Copy a pre-encoded sprite into the shadow of one panel. Only the bytes owned
+// by the sprite are replaced, so a digit on one half leaves the other half alone.
+void led_draw_sprite_at(int panel, enum led_sprite_id id, bool right_left)
 {
-    if (idx < 0 || idx >= 10) {
-        printk("Invalid index %d\n", idx);
+    if (id >= SPRITE_COUNT || panel < 0 || panel >= LED_PANEL_COUNT) {
+        LOG_ERR("Invalid sprite %d on panel %d", id, panel);
         return;
     }
-    display_pattern(led_patterns[idx], left_right);
+
+    const struct led_sprite *sprite = &sprites[id];
+    const uint8_t *image = sprite->ram[sprite->wide ? LEFT : right_left];
+    const uint8_t *mask = sprite_masks[sprite->wide ? MASK_WIDE : right_left];
+
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+
+    uint8_t *ram = frame[panel];
+    uint8_t dirty = 0;
+
+    for (int i = 0; i < LED_RAM_SIZE; i++) {
+        uint8_t b = (ram[i] & ~mask[i]) | image[i];
+
+        dirty |= (uint8_t)(b != ram[i]) << (i / 2);
+        ram[i] = b;
+    }
+    dirty_rows[panel] |= dirty;
+    k_spin_unlock(&fb_lock, key);
 }
 
-void led_on_center(void)
+void led_draw_sprite(enum led_sprite_id id, bool right_left)
 {
-    // led_off_all();
-    led_set_brightness(led, 0, 0);
+    led_draw_sprite_at(0, id, right_left);
+}
 
-    for(int i = 38; i < 95; i+=16){
-        led_on(led, i);
-        led_on(led, i+1);
-        led_on(led, i+2);
-        led_on(led, i+3);
+// 8x8 bit matrix transpose, in[i] bit j -> out[j] bit i, in three
+// swap steps on one 64-bit word (Hacker's Delight 7-3)
+static void transpose8(const uint8_t in[8], uint8_t out[8])
+{
+    uint64_t x = 0;
+
+    for (int i = 0; i < 8; i++) {
+        x |= (uint64_t)in[i] << (8 * i);
     }
 
-    k_sleep(K_MSEC(100));
+    x = (x & 0xAA55AA55AA55AA55ULL) | ((x & 0x00AA00AA00AA00AAULL) << 7) |
+        ((x >> 7) & 0x00AA00AA00AA00AAULL);
+    x = (x & 0xCCCC3333CCCC3333ULL) | ((x & 0x0000CCCC0000CCCCULL) << 14) |
+        ((x >> 14) & 0x0000CCCC0000CCCCULL);
+    x = (x & 0xF0F0F0F00F0F0F0FULL) | ((x & 0x00000000F0F0F0F0ULL) << 28) |
+        ((x >> 28) & 0x00000000F0F0F0F0ULL);
+
+    for (int i = 0; i < 8; i++) {
+        out[i] = x >> (8 * i);
+    }
 }
 
-void led_on_right(void)
+// Replace canvas columns x..x+width-1 with column-major data (one byte per
+// column, bit 0 = top row). x and width must be multiples of 8, each block of
+// 8 columns becomes one byte in each of the 8 rows of that half panel.
+void led_draw_columns(int x, const uint8_t *cols, int width)
 {
-    // led_off_all();
+    if (x < 0 || x % 8 || width % 8 || x + width > LED_CANVAS_WIDTH) {
+        LOG_ERR("Invalid column block %d+%d", x, width);
+        return;
+    }
 
-    led_on(led, 26);
-    led_on(led, 38); led_on(led, 39); led_on(led, 40); led_on(led, 41); led_on(led, 42); led_on(led, 43);
-    led_on(led, 54); led_on(led, 55); led_on(led, 56); led_on(led, 57); led_on(led, 58); led_on(led, 59); led_on(led, 60); led_on(led, 61);
-    led_on(led, 70); led_on(led, 71); led_on(led, 72); led_on(led, 73); led_on(led, 74); led_on(led, 75); led_on(led, 76); led_on(led, 77);
-    led_on(led, 86); led_on(led, 87); led_on(led, 88); led_on(led, 89); led_on(led, 90); led_on(led, 91);
-    led_on(led, 106);
+    for (int block = 0; block < width; block += 8) {
+        int panel = (x + block) / 16;
+        int half = ((x + block) % 16) / 8;
+        uint8_t rows[LED_ROWS];
+        uint8_t dirty = 0;
 
-    k_sleep(K_MSEC(100));
+        transpose8(&cols[block], rows);
+
+        k_spinlock_key_t key = k_spin_lock(&fb_lock);
+
+        for (int y = 0; y < LED_ROWS; y++) {
+            uint8_t *byte = &frame[panel][y * 2 + half];
+
+            dirty |= (uint8_t)(*byte != rows[y]) << y;
+            *byte = rows[y];
+        }
+        dirty_rows[panel] |= dirty;
+        k_spin_unlock(&fb_lock, key);
+    }
 }
 
-void led_on_left(void)
+void led_show_sprite(enum led_sprite_id id, bool right_left)
 {
-    // led_off_all();
+    led_draw_sprite(id, right_left);
+    led_flush();
+}
+
+static void flush_done(int result, void *user_data);
+
+// Queue the dirty rows of every panel on the bus and return, never waits for
+// the transfers.
+int led_flush(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+    uint8_t dirty_panels = 0;
+
+    for (int p = 0; p < LED_PANEL_COUNT; p++) {
+        dirty_panels |= (uint8_t)(dirty_rows[p] != 0) << p;
+    }
+
+    if (dirty_panels == 0) {
+        k_spin_unlock(&fb_lock, key);
+        return 0;
+    }
+
+    if (flush_outstanding) {
+        // picked up by flush_done() together with whatever else changes until then
+        if (!flush_pending) {
+            flush_pending = true;
+            flush_requested = perf_start();
+        }
+        coalesced++;
+        k_spin_unlock(&fb_lock, key);
+        return 0;
+    }
+
+    uint8_t len[LED_PANEL_COUNT];
+
+    for (int p = 0; p < LED_PANEL_COUNT; p++) {
+        if (!(dirty_panels & BIT(p))) {
+            continue;
+        }
 
-    led_on(led, 21);
-    led_on(led, 36); led_on(led, 37); led_on(led, 38); led_on(led, 39); led_on(led, 40); led_on(led, 41);
-    led_on(led, 50); led_on(led, 51); led_on(led, 52); led_on(led, 53); led_on(led, 54); led_on(led, 55); led_on(led, 56); led_on(led, 57);
-    led_on(led, 66); led_on(led, 67); led_on(led, 68); led_on(led, 69); led_on(led, 70); led_on(led, 71); led_on(led, 72); led_on(led, 73);
-    led_on(led, 84); led_on(led, 85); led_on(led, 86); led_on(led, 87); led_on(led, 88); led_on(led, 89);
-    led_on(led, 101);
+        // one write covering the first to the last dirty row, the address pointer auto-increments
+        int first = __builtin_ctz(dirty_rows[p]);
+        int last = 31 - __builtin_clz(dirty_rows[p]);
 
-    k_sleep(K_MSEC(100));
+        len[p] = (last - first + 1) * 2;
+        tx_buf[p][0] = first * 2; // display data address pointer
+        memcpy(&tx_buf[p][1], &frame[p][first * 2], len[p]);
+        dirty_rows[p] = 0;
+    }
+
+    flush_outstanding = POPCOUNT(dirty_panels);
+    flush_failed = false;
+    flush_start = flush_pending ? flush_requested : perf_start();
+    flush_pending = false;
+    flushes++;
+    panel_writes += flush_outstanding;
+    k_spin_unlock(&fb_lock, key);
+
+    int err = 0;
+
+    for (int p = 0; p < LED_PANEL_COUNT; p++) {
+        if (!(dirty_panels & BIT(p))) {
+            continue;
+        }
+
+        int ret = i2c_queue_write(panels[p].iodev, I2C_QUEUE_PRIO_REDRAW, tx_buf[p], len[p] + 1,
+                                  flush_done, (void *)(uintptr_t)p);
+        if (ret < 0) {
+            LOG_ERR("Failed to queue LED panel %d (%d)", p, ret);
+            flush_done(ret, (void *)(uintptr_t)p);
+            err = ret;
+        }
+    }
+    return err;
 }
 
-void led_on_up(void)
+// Runs in the I2C queue thread when one panel of the pass is on the chip
+static void flush_done(int result, void *user_data)
 {
-    // led_off_all();
+    int panel = (uintptr_t)user_data;
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
 
-    led_on(led, 23); led_on(led, 24);
-    led_on(led, 37); led_on(led, 38); led_on(led, 39); led_on(led, 40); led_on(led, 41); led_on(led, 42);
-    led_on(led, 52); led_on(led, 53); led_on(led, 54); led_on(led, 55); led_on(led, 56); led_on(led, 57); led_on(led, 58); led_on(led, 59);
-    led_on(led, 70); led_on(led, 71); led_on(led, 72); led_on(led, 73);
-    led_on(led, 86); led_on(led, 87); led_on(led, 88); led_on(led, 89);
+    if (result < 0) {
+        // the chip state is unknown, resend the whole panel with the next flush
+        LOG_ERR("Failed to flush LED panel %d (%d)", panel, result);
+        dirty_rows[panel] = BIT_MASK(LED_ROWS);
+        flush_failed = true;
+    }
 
-    k_sleep(K_MSEC(100));
+    if (--flush_outstanding) {
+        k_spin_unlock(&fb_lock, key);
+        return;
+    }
+
+    perf_stop(&flush_stat, flush_start);
+
+    // a failed pass is not retried from here, the next led_flush() resends it
+    bool more = flush_pending && !flush_failed;
+    k_spin_unlock(&fb_lock, key);
+
+    if (more) {
+        led_flush();
+    } else {
+        k_sem_give(&flush_idle);
+    }
 }
 
-void led_on_down(void)
+// Wait until every flush so far is on the chip
+int led_flush_wait(k_timeout_t timeout)
 {
-    // led_off_all();
+    k_sem_reset(&flush_idle);
 
-    led_on(led, 38); led_on(led, 39); led_on(led, 40); led_on(led, 41);
-    led_on(led, 54); led_on(led, 55); led_on(led, 56); led_on(led, 57);
-    led_on(led, 68); led_on(led, 69); led_on(led, 70); led_on(led, 71); led_on(led, 72); led_on(led, 73); led_on(led, 74); led_on(led, 75);
-    led_on(led, 85); led_on(led, 86); led_on(led, 87); led_on(led, 88); led_on(led, 89); led_on(led, 90);
-    led_on(led, 103); led_on(led, 104);
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+    bool busy = flush_outstanding != 0;
+    k_spin_unlock(&fb_lock, key);
 
-    k_sleep(K_MSEC(100));
+    return busy ? k_sem_take(&flush_idle, timeout) : 0;
+}
 
+void led_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] led: %u passes with %u panel writes (%d panels), %u flushes coalesced, "
+           "%u commands\n", flushes, panel_writes, LED_PANEL_COUNT, coalesced, commands_sent);
+#endif
+    perf_print(&flush_stat);
+    i2c_queue_print_stats();
 }
 
-void display_pattern(const uint8_t pattern[8], bool left_right)
+// Redraw one digit on both halves the old way (one I2C transaction per LED) and
+// through the framebuffer, and print how long each took.
+void led_benchmark(void)
 {
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            int led_index = row * 16 + col;  // Default for left 8x8 part
-            if (left_right) { // LEFT : 0, RIGHT : 1
-                led_index += 8; // Shift to the right 8x8 part
-            }
-            if (led_index >= 0 && led_index < MAX_LED_NUM) {
+    PERF_STAT_DEFINE(legacy_stat, "per-LED redraw");
+    PERF_STAT_DEFINE(fb_stat, "framebuffer redraw");
+    static const uint8_t pattern[8] = {
+        0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000000
+    };
+
+    uint32_t start = perf_start();
+    for (int half = LEFT; half <= RIGHT; half++) {
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 8; col++) {
+                int led_index = row * 16 + col + (half ? 8 : 0);
+
                 if (pattern[row] & (1 << (7 - col))) {
-                    if (led_on(led, led_index) < 0) {
-                        printk("Failed to turn on LED %d\n", led_index);
-                    }
+                    led_on(led, led_index);
                 } else {
-                    if (led_off(led, led_index) < 0) {
-                        printk("Failed to turn off LED %d\n", led_index);
-                    }
+                    led_off(led, led_index);
                 }
-            } else {
-                printk("LED index %d out of range\n", led_index);
             }
         }
     }
+    perf_stop(&legacy_stat, start);
+
+    // force a full resync so both variants push the same amount of pixels
+    led_flush_wait(K_FOREVER);
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+    dirty_rows[0] = BIT_MASK(LED_ROWS);
+    k_spin_unlock(&fb_lock, key);
+
+    start = perf_start();
+    led_draw_sprite(SPRITE_DIGIT_8, LEFT);
+    led_draw_sprite(SPRITE_DIGIT_8, RIGHT);
+    led_flush();
+    led_flush_wait(K_FOREVER);
+    perf_stop(&fb_stat, start);
+
+    perf_print(&legacy_stat);
+    perf_print(&fb_stat);
+}
+
+static void blank_frame(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+
+    memset(frame, 0, sizeof(frame));
+    memset(dirty_rows, BIT_MASK(LED_ROWS), sizeof(dirty_rows));
+    k_spin_unlock(&fb_lock, key);
+}
+
+// Blank the shadow and the whole display RAM with a single burst write per panel.
+int led_clear(void)
+{
+    blank_frame();
+    return led_flush();
+}
+
+// With blank-then-swap enabled, led_off_all() only blanks the shadow. The next
+// draw then sends the blank and the new picture together in one flush, so the
+// matrix goes from the old frame to the new one without an empty frame between.
+void led_set_blank_swap(bool enable)
+{
+    blank_swap = enable;
+}
+
+void led_off_all(void)
+{
+    if (blank_swap) {
+        blank_frame();
+        return;
+    }
+
+    led_clear();
+}
+
+void led_on_idx(int idx, bool left_right)
+{
+    if (idx < 0 || idx >= 10) {
+        LOG_ERR("Invalid index %d", idx);
+        return;
+    }
+    led_show_sprite(SPRITE_DIGIT(idx), left_right);
+}
+
+static void submit_command(struct led_command *command);
+
+// One panel is done with the command, the last one resends a newer value
+static void command_release(struct led_command *command)
+{
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+    bool resend = --command->outstanding == 0 && command->cmd != command->sent;
+
+    k_spin_unlock(&fb_lock, key);
+
+    if (resend) {
+        submit_command(command);
+    }
+}
+
+static void command_done(int result, void *user_data)
+{
+    command_release(user_data);
+}
+
+static void submit_command(struct led_command *command)
+{
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+
+    if (command->outstanding) {
+        k_spin_unlock(&fb_lock, key);
+        return; // the last completion of the pass on the bus sends cmd
+    }
+
+    command->outstanding = LED_PANEL_COUNT;
+    command->sent = command->cmd;
+    k_spin_unlock(&fb_lock, key);
+
+    for (int p = 0; p < LED_PANEL_COUNT; p++) {
+        if (i2c_queue_write(panels[p].iodev, I2C_QUEUE_PRIO_CONTROL, &command->sent, 1,
+                            command_done, command) < 0) {
+            command_release(command);
+        } else {
+            commands_sent++;
+        }
+    }
+}
+
+static void send_command(struct led_command *command, uint8_t cmd)
+{
+    k_spinlock_key_t key = k_spin_lock(&fb_lock);
+
+    command->cmd = cmd;
+    k_spin_unlock(&fb_lock, key);
+
+    submit_command(command);
+}
+
+// Set the HT16K33 duty cycle of every panel, 0 = 1/16 .. 15 = 16/16, without
+// waiting for the bus
+void led_set_dimming(uint8_t level)
+{
+    send_command(&dim_command, HT16K33_CMD_DIMMING | MIN(level, LED_DIMMING_MAX));
+}
+
+uint8_t led_get_dimming(void)
+{
+    return dim_command.cmd & LED_DIMMING_MAX;
+}
+
+// Let the chips blink the whole display on their own, no CPU or bus work
+// until the rate changes
+void led_set_blink(enum led_blink rate)
+{
+    send_command(&blink_command, HT16K33_CMD_DISPLAY_SETUP | (rate << 1) | HT16K33_DISPLAY_ON);
+}
+
+void led_on_center(void)
+{
+    // led_off_all();
+    led_set_dimming(0);
+    led_show_sprite(SPRITE_ARROW_CENTER, LEFT);
+}
+
+void led_on_right(void)
+{
+    led_show_sprite(SPRITE_ARROW_RIGHT, LEFT);
+}
+
+void led_on_left(void)
+{
+    led_show_sprite(SPRITE_ARROW_LEFT, LEFT);
+}
+
+void led_on_up(void)
+{
+    led_show_sprite(SPRITE_ARROW_UP, LEFT);
+}
+
+void led_on_down(void)
+{
+    led_show_sprite(SPRITE_ARROW_DOWN, LEFT);
 }
 
 void display_success(void)
 {
-    display_pattern(password_success, LEFT);
-    display_pattern(password_success, RIGHT);
+    led_draw_sprite(SPRITE_SMILE, LEFT);
+    led_draw_sprite(SPRITE_SMILE, RIGHT);
+    led_flush();
 }
 
 void display_not_success(void)
 {
-    display_pattern(password_unsuccess, LEFT);
-    display_pattern(password_unsuccess, RIGHT);
+    led_draw_sprite(SPRITE_CRY, LEFT);
+    led_draw_sprite(SPRITE_CRY, RIGHT);
+    led_flush();
 }
\ No newline at end of file
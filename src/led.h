@@ -2,29 +2,68 @@
 #define LED_H
 
 #include <zephyr/drivers/led.h>
+#include <zephyr/drivers/i2c.h>
 #include <zephyr/drivers/kscan.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/kernel.h>
 
+#include "sprites.h"
+
 #define LEFT 0
 #define RIGHT 1
 
+// The HT16K33 that carries the keypad. LEFT/RIGHT drawing goes to panel 0.
 #define LED_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(holtek_ht16k33)
 #define KEY_NODE DT_CHILD(LED_NODE, keyscan)
 
+// Every enabled HT16K33 at 0x70..0x77 is one 16x8 panel, placed left to right
+// by address on one logical canvas.
+#define LED_PANEL_BASE_ADDR 0x70
+#define LED_PANEL_COUNT DT_NUM_INST_STATUS_OKAY(holtek_ht16k33)
+#define LED_CANVAS_WIDTH (16 * LED_PANEL_COUNT)
+#define LED_CANVAS_HEIGHT 8
+
+BUILD_ASSERT(LED_PANEL_COUNT >= 1 && LED_PANEL_COUNT <= 8, "1 to 8 HT16K33 panels supported");
+
 #define MAX_LED_NUM 128
 
-#define MAX_ROTARY_IDX 10 // ?창�궗쨘????쩐횏? 15???????��?
+// HT16K33 display RAM: 8 rows, 2 bytes per row (left half, right half)
+#define LED_ROWS 8
+#define LED_RAM_SIZE 16
 
-static const struct device *const led = DEVICE_DT_GET(LED_NODE);
+#define LED_DIMMING_MAX 15
 
-extern const uint8_t led_patterns[10][8];
+// HT16K33 hardware blink rates, in the chip's own encoding
+enum led_blink {
+    LED_BLINK_OFF,
+    LED_BLINK_2HZ,
+    LED_BLINK_1HZ,
+    LED_BLINK_HALF_HZ,
+};
 
-extern const uint8_t password_success[8];
-extern const uint8_t password_unsuccess[8];
+// Set to 1 to time the old per-LED redraw against the framebuffer flush at boot
+#define LED_BENCHMARK 0
+
+#define MAX_ROTARY_IDX 10 // ?창�궗쨘????쩐횏? 15???????��?
+
+static const struct device *const led = DEVICE_DT_GET(LED_NODE);
 
 int led_init(void);
 
+void led_draw_sprite(enum led_sprite_id id, bool right_left);
+void led_draw_sprite_at(int panel, enum led_sprite_id id, bool right_left);
+void led_draw_columns(int x, const uint8_t *cols, int width);
+void led_show_sprite(enum led_sprite_id id, bool right_left);
+int led_flush(void);
+int led_flush_wait(k_timeout_t timeout);
+int led_clear(void);
+void led_set_blank_swap(bool enable);
+void led_set_dimming(uint8_t level);
+uint8_t led_get_dimming(void);
+void led_set_blink(enum led_blink rate);
+void led_print_stats(void);
+void led_benchmark(void);
+
 void led_off_all(void);
 void led_on_idx(int idx, bool right_left);
 void led_on_center(void);
@@ -33,7 +72,6 @@ void led_on_left(void);
 void led_on_up(void);
 void led_on_down(void);
 
-void display_pattern(const uint8_t pattern[8], bool right_left);
 void display_success(void);
 void display_not_success(void);
 
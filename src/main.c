@@ -14,12 +14,25 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/drivers/adc.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/logging/log.h>
 #include <zephyr/sys/printk.h>
 #include <zephyr/sys/util.h>
 
 #include "led.h"
 #include "batterydisplay.h"
 #include "cts.h"
+#include "joystick.h"
+#include "events.h"
+#include "rotary.h"
+#include "ui.h"
+#include "countdown.h"
+#include "keypad.h"
+#include "text.h"
+#include "anim.h"
+#include "status.h"
+#include "telemetry.h"
+#include "audit.h"
+#include "perf.h"
 
 #include <zephyr/types.h>
 #include <string.h>
@@ -35,43 +48,19 @@
 #include <zephyr/bluetooth/services/hrs.h>
 #include <zephyr/bluetooth/services/ias.h>
 
-// [BLE Part]
-// Custom Service Variables
-#define BT_UUID_CUSTOM_SERVICE_VAL \
-    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef0)
-
-#define BT_UUID_CUSTOM_MESSAGE_VAL \
-    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef5)
-
-static struct bt_uuid_128 custom_service_uuid = BT_UUID_INIT_128(BT_UUID_CUSTOM_SERVICE_VAL);
-static struct bt_uuid_128 custom_message_uuid = BT_UUID_INIT_128(BT_UUID_CUSTOM_MESSAGE_VAL);
+LOG_MODULE_REGISTER(app, CONFIG_SAFE_APP_LOG_LEVEL);
 
+// [BLE Part]
+// The custom service lives in status.c, this is the final message for the matrix
 #define CUSTOM_MESSAGE_MAX_LEN 50
 
-static uint8_t custom_message_value[CUSTOM_MESSAGE_MAX_LEN + 1] = "your safe is secured."; //when connect device with bluetooth
-
-static ssize_t read_custom_message(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len, uint16_t offset)
-{
-    const char *value = attr->user_data;
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, value, strlen(value));
-}
-
-// Custom Service Declaration
-BT_GATT_SERVICE_DEFINE(custom_svc,
-                       BT_GATT_PRIMARY_SERVICE(&custom_service_uuid),
-                       BT_GATT_CHARACTERISTIC(&custom_message_uuid.uuid,
-                                              BT_GATT_CHRC_READ,
-                                              BT_GATT_PERM_READ,
-                                              read_custom_message, NULL, custom_message_value));
-
-static const struct bt_data ad[] = {
-    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-    BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_CUSTOM_SERVICE_VAL),
-};
+static uint8_t custom_message_value[CUSTOM_MESSAGE_MAX_LEN + 1] = "your safe is secured.";
 
 void mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx)
 {
-    printk("Updated MTU: TX: %d RX: %d bytes\n", tx, rx);
+    LOG_INF("Updated MTU: TX: %d RX: %d bytes", tx, rx);
+    status_set_mtu(tx);
+    telemetry_set_mtu(tx);
 }
 
 static struct bt_gatt_cb gatt_callbacks = {
@@ -81,17 +70,18 @@ static void connected(struct bt_conn *conn, uint8_t err)
 {
     if (err)
     {
-        printk("Connection failed (err 0x%02x)\n", err);
+        LOG_ERR("Connection failed (err 0x%02x)", err);
     }
     else
     {
-        printk("Connected\n");
+        LOG_INF("Connected");
     }
 }
 
 static void disconnected(struct bt_conn *conn, uint8_t reason)
 {
-    printk("Disconnected (reason 0x%02x)\n", reason);
+    LOG_INF("Disconnected (reason 0x%02x)", reason);
+    status_set_mtu(BT_ATT_DEFAULT_LE_MTU);
 }
 
 BT_CONN_CB_DEFINE(conn_callbacks) = {
@@ -99,11 +89,46 @@ BT_CONN_CB_DEFINE(conn_callbacks) = {
     .disconnected = disconnected,
 };
 
-static void bt_ready(void)
+// [Boot Timing]
+// ms since the kernel started, 0 = not reached yet
+static uint32_t boot_frame_ms, boot_input_ready_ms, boot_first_input_ms;
+static atomic_t boot_settings_ms, boot_adv_ms; // set by bt_ready()
+
+// Settings and advertising finish on their own schedule, bt_ready() reports
+// them once they are done
+static void print_boot_ble_report(void)
 {
-    int err;
+#if PERF_ENABLED
+    if (atomic_get(&boot_adv_ms)) {
+        printk("[perf] boot: settings loaded %u ms, advertising %u ms\n",
+               (uint32_t)atomic_get(&boot_settings_ms), (uint32_t)atomic_get(&boot_adv_ms));
+    } else {
+        printk("[perf] boot: settings and advertising pending\n");
+    }
+#endif
+}
 
-    printk("Bluetooth initialized\n");
+static void print_boot_report(void)
+{
+#if PERF_ENABLED
+    printk("[perf] boot: first frame %u ms, input ready %u ms, first input %u ms\n",
+           boot_frame_ms, boot_input_ready_ms, boot_first_input_ms);
+    print_boot_ble_report();
+#endif
+}
+
+// Called by the host once the controller is up, on the system work queue.
+// The settings scan runs here, never on the input path. Advertising has to
+// wait for it, the identity and bonds are stored in settings.
+static void bt_ready(int err)
+{
+    if (err)
+    {
+        LOG_ERR("Bluetooth init failed (err %d)", err);
+        return;
+    }
+
+    LOG_INF("Bluetooth initialized");
 
     cts_init();
 
@@ -111,50 +136,85 @@ static void bt_ready(void)
     {
         settings_load();
     }
+    atomic_set(&boot_settings_ms, k_uptime_get_32());
 
-    err = bt_le_adv_start(BT_LE_ADV_CONN_NAME, ad, ARRAY_SIZE(ad), NULL, 0);
+    err = status_adv_start(); // flags, service UUID and the status broadcast
     if (err)
     {
-        printk("Advertising failed to start (err %d)\n", err);
+        LOG_ERR("Advertising failed to start (err %d)", err);
         return;
     }
 
-    printk("Advertising successfully started\n");
+    atomic_set(&boot_adv_ms, k_uptime_get_32());
+    LOG_INF("Advertising successfully started");
+    print_boot_ble_report();
 }
 
+// Returns at once, bt_ready() follows asynchronously
 void start_bluetooth(void)
 {
     int err;
 
-    err = bt_enable(NULL);
+    bt_gatt_cb_register(&gatt_callbacks);
+
+    err = bt_enable(bt_ready);
     if (err)
     {
-        printk("Bluetooth init failed (err %d)\n", err);
-        return;
+        LOG_ERR("Bluetooth init failed (err %d)", err);
     }
+}
 
-    bt_ready();
+// [Display Bring-up]
+// Matrix, keypad and battery display come up on their own thread while main()
+// calibrates the inputs, both mostly wait for their bus.
+#define DISPLAY_BOOT_STACK_SIZE 1024
 
-    bt_gatt_cb_register(&gatt_callbacks);
+K_THREAD_STACK_DEFINE(display_boot_stack, DISPLAY_BOOT_STACK_SIZE);
+static struct k_thread display_boot_thread;
+static int display_boot_err;
 
-    printk("Bluetooth initialized\n");
-}
+static void display_boot(void *p1, void *p2, void *p3)
+{
+    // I2C Matrix initialize, returns once the first frame is on the panels
+    if (led_init() < 0) {
+        LOG_ERR("LED init failed");
+        display_boot_err = -1;
+        return;
+    }
+    boot_frame_ms = k_uptime_get_32();
 
-// [LED Part]
-#if !DT_NODE_EXISTS(DT_ALIAS(qdec0))
-#error "Unsupported board: qdec0 devicetree alias is not defined"
+#if LED_BENCHMARK
+    led_benchmark();
 #endif
 
-#define SW_NODE DT_NODELABEL(gpiosw)
-#if !DT_NODE_HAS_STATUS(SW_NODE, okay)
-#error "Unsupported board: gpiosw devicetree alias is not defined or enabled"
-#endif
-static const struct gpio_dt_spec sw = GPIO_DT_SPEC_GET(SW_NODE, gpios);
+    // keypad on the HT16K33 keyscan
+    if (keypad_init() < 0) {
+        LOG_ERR("Keypad init failed");
+        display_boot_err = -1;
+        return;
+    }
+
+    // joystick redraws: blank + arrow go out as one I2C write
+    led_set_blank_swap(true);
+
+    // battery display initialize
+    if (batterydisplay_init() < 0) {
+        LOG_ERR("Battery display init failed");
+        display_boot_err = -1;
+        return;
+    }
+}
 
+// [LED Part]
 static int rotary_idx = 0;
 
+// entry time with the rotary selector: first turn until the digit / whole code is clicked in
+static PERF_STAT_DEFINE(digit_entry_stat, "digit entry");
+static PERF_STAT_DEFINE(code_entry_stat, "code entry");
+static uint32_t digit_entry_start, code_entry_start;
+static bool digit_entry_running, code_entry_running;
+
 #define MAX_SAVED_NUMBERS 4 //MAX number of password.
-static bool sw_led_flag = false; // can save number in encoder. 
 static int saved_numbers[MAX_SAVED_NUMBERS] = { -1, -1, -1, -1 }; // when click the encoder, the number will save. 
 static int saved_index = 0; //count the number that saved by rotary
 static int password[MAX_SAVED_NUMBERS] = {1, 2, 3, 4}; // password of locker, (it can change by user)
@@ -163,35 +223,26 @@ int flag_password_moved = false;
 int time_out = false; //break when time_out get true
 int success = false; //when password success it will quit program.
 
-static struct gpio_callback sw_cb_data;
-
-extern const uint8_t led_patterns[10][8];
-
 // [Joystick Part]
 static int saved_number_joystick[MAX_SAVED_NUMBERS] = { -1, -1, -1, -1 };
 static int password_joystick[MAX_SAVED_NUMBERS] = {1, 2, 3, 4}; // Password of joystick
 static int saved_index_joystick = 0;
-int flag_joystick = false;
 int flag_joystick_moved = false;
 
-#if !DT_NODE_EXISTS(DT_PATH(zephyr_user)) || \
-    !DT_NODE_HAS_PROP(DT_PATH(zephyr_user), io_channels)
-#error "No suitable devicetree overlay specified"
-#endif
+// [Keypad Part]
+static int saved_number_keypad[MAX_SAVED_NUMBERS] = { -1, -1, -1, -1 };
+static int password_keypad[MAX_SAVED_NUMBERS] = {1, 2, 3, 4}; // Password of keypad
+static int saved_index_keypad = 0;
+int keypad_success = false;
 
-#define DT_SPEC_AND_COMMA(node_id, prop, idx) \
-    ADC_DT_SPEC_GET_BY_IDX(node_id, idx),
+static enum status_stage stage = STATUS_STAGE_IDLE;
 
-/* Data of ADC io-channels specified in devicetree. */
-static const struct adc_dt_spec adc_channels[] = {
-    DT_FOREACH_PROP_ELEM(DT_PATH(zephyr_user), io_channels,
-                 DT_SPEC_AND_COMMA)
-};
-
-int32_t preX = 0 , perY = 0;
-static const int ADC_MAX = 1023;
-static const int AXIS_DEVIATION = ADC_MAX / 2;
-int32_t nowX = 0, nowY = 0;
+// status and audit log both record which stage an outcome belongs to
+static void enter_stage(enum status_stage next)
+{
+    stage = next;
+    status_set_stage(next);
+}
 
 // [LED Part]
 bool compare_arrays(int *array1, int *array2, int size) {
@@ -203,389 +254,469 @@ bool compare_arrays(int *array1, int *array2, int size) {
   return true;
 }
 
-void sw_callback(const struct device *dev, struct gpio_callback *cb, uint32_t pins) //encoder click 하는 부분
+// encoder click, called from main() for every debounced press
+void handle_switch_press(void)
 {
-    printk("SW pressed, displaying number %d on the right matrix\n", rotary_idx);
-    sw_led_flag = true;
+    LOG_DBG("SW pressed, displaying number %d on the right matrix", rotary_idx);
     flag_password_moved = true;
 
+    if (saved_index == MAX_SAVED_NUMBERS) { // code already complete, waiting for the result
+        return;
+    }
+
     // Save the current number
     saved_numbers[saved_index++] = rotary_idx;
-  
+    status_set_digits(saved_index);
+
     // Print saved numbers
     if (saved_index == MAX_SAVED_NUMBERS) {  // when saved index has 4 number.
-        printk("complete\n");
-        printk("Saved numbers: ");
-        for (int i = 0; i < MAX_SAVED_NUMBERS; i++) { //number that user save (just print even is false)
-            printk("%d ", saved_numbers[i]);
-        }
-        printk("\n");
+        // number that user save (just print even is false), one message for all four
+        LOG_INF("complete, saved numbers: %d %d %d %d", saved_numbers[0], saved_numbers[1],
+                saved_numbers[2], saved_numbers[3]);
         
         if (compare_arrays(saved_numbers, password, MAX_SAVED_NUMBERS)) { //compare if password is correct or wrong
-            printk("Password matched!\n");
+            LOG_INF("Password matched!");
             password_matched = true;
-            strncpy(custom_message_value, "password success", CUSTOM_MESSAGE_MAX_LEN); //send "password success" to bluetooth
+            audit_log(AUDIT_EVENT_ATTEMPT_OK, stage);
         } else {
-            printk("Password not matched!\n");
+            LOG_INF("Password not matched!");
             password_matched = false;
-            strncpy(custom_message_value, "password fail", CUSTOM_MESSAGE_MAX_LEN);
+            audit_log(AUDIT_EVENT_ATTEMPT_FAIL, stage);
         }
+        status_add_attempt();
     }
 }
 
 void check_password_matching(void) {
     if (password_matched) { //if password_matched is true display smile face to LED matrix
-        display_success(); 
-        success = true; //progroam quit
+        // the stage ends once the smile has been up for UI_FEEDBACK_MS
+        ui_show_feedback(UI_FEEDBACK_CODE_OK);
     } else {
-        display_not_success();
-        saved_index = 0; // initialize saved_index to 0 
-        k_msleep(3000);
-        rotary_idx = 0; // reset led matrix to 0 when password fail
-        display_pattern(led_patterns[rotary_idx], RIGHT); // LED matrix to 0 - right
-        display_pattern(led_patterns[rotary_idx], LEFT);  // LED matrix to 0 - left
+        // the crying face stays up for UI_FEEDBACK_MS, then reset_rotary_display() runs
+        ui_show_feedback(UI_FEEDBACK_CODE_FAIL);
     }
+    saved_index = 0; // initialize saved_index to 0 
+    status_set_digits(0);
 }
 
-void display_rotary_led(int32_t rotary_val)
+void reset_rotary_display(void)
 {
-    if (rotary_val == 0) { //make led matrix increase or decrease when rotate the encoder more or less than 17 degree
-    } else if (rotary_val - 17 > 0) {
-        rotary_idx++;
-    } else if (rotary_val + 17 < 0) {
-        rotary_idx--;
-    }
+    rotary_idx = 0; // reset led matrix to 0 when password fail
+    led_draw_sprite(SPRITE_DIGIT(rotary_idx), RIGHT); // LED matrix to 0 - right
+    led_draw_sprite(SPRITE_DIGIT(rotary_idx), LEFT);  // LED matrix to 0 - left
+    led_flush();
+}
+
+// a faster step would wrap around the digits and read as turning backwards
+BUILD_ASSERT(ROTARY_ACCEL_MAX_STEP < MAX_ROTARY_IDX / 2, "rotary step too large for the digits");
 
+void display_rotary_led(int32_t steps)
+{
+    // steps are detents already scaled by the acceleration curve, one per slow detent
+    rotary_idx = (rotary_idx + steps) % MAX_ROTARY_IDX;
     if (rotary_idx < 0) {
-        rotary_idx = MAX_ROTARY_IDX - 1;
-    } else if (rotary_idx >= MAX_ROTARY_IDX) {
-        rotary_idx = 0;
+        rotary_idx += MAX_ROTARY_IDX;
     }
 
-    printk("Rotary encoder moved, displaying number %d on the left matrix\n", rotary_idx);
+    LOG_DBG("Rotary encoder moved, displaying number %d on the left matrix", rotary_idx);
     led_on_idx(rotary_idx, LEFT);
 }
 
-// [Joystick Part]
-bool isChange(void)
+// [Keypad Part]
+void handle_key(int8_t key)
 {
-    if ((nowX < (preX - 50)) || nowX > (preX+50)) {
-        preX = nowX;
-        return true;
+    if (ui_busy()) {
+        return;
+    }
+
+    if (key == KEYPAD_KEY_CLEAR) {
+        LOG_INF("Keypad cleared");
+        saved_index_keypad = 0;
+        status_set_digits(0);
+        led_clear();
+        return;
     }
 
-    if ((nowY < (perY - 50)) || nowY > (perY+50)) {
-        perY = nowY;
-        return true;
+    LOG_DBG("Key %d pressed", key);
+    if (saved_index_keypad < MAX_SAVED_NUMBERS) {
+        saved_number_keypad[saved_index_keypad++] = key;
+        status_set_digits(saved_index_keypad);
+        led_on_idx(key, RIGHT);
     }
-    
-    return false;
+}
+
+void check_keypad_matching(void)
+{
+    if (compare_arrays(saved_number_keypad, password_keypad, MAX_SAVED_NUMBERS)) {
+        LOG_INF("Keypad code matched!");
+        audit_log(AUDIT_EVENT_ATTEMPT_OK, stage);
+        keypad_success = true; // the smile is shown once the stage is left
+    } else {
+        LOG_INF("Keypad code not matched!");
+        audit_log(AUDIT_EVENT_ATTEMPT_FAIL, stage);
+        ui_show_feedback(UI_FEEDBACK_KEYPAD_FAIL);
+    }
+    status_add_attempt();
+    saved_index_keypad = 0;
+    status_set_digits(0);
 }
 
 // [Battery Display Part]
-static int seconds = 121; //
-int seconds_count = 0;
+// battery gage per sec, called on every countdown tick
+void update_battery_display(int32_t remaining_ms)
+{
+    // show level of battery
+    display_level(countdown_level(remaining_ms));
+}
 
-//battery gage per sec
-void update_battery_display(int stage)
+void handle_timeout(void)
 {
-    // Battery Display Level
-    uint8_t level = 0;
-
-    // every 12 seconds battery level get change
-    if (seconds >= 120) {
-        level = 10;
-    } else if (seconds >= 108) {
-        level = 9;
-    } else if (seconds >= 96) {
-        level = 8;
-    } else if (seconds >= 84) {
-        level = 7;
-    } else if (seconds >= 72) {
-        level = 6;
-    } else if (seconds >= 60) {
-        level = 5;
-    } else if (seconds >= 48) {
-        level = 4;
-    } else if (seconds >= 36) {
-        level = 3;
-    } else if (seconds >= 24) {
-        level = 2;
-    } else if (seconds > 12) {
-        level = 1;
-    } else if (seconds == 0) {
-        level = 0;
+    if (time_out) {
+        return;
     }
+    time_out = true;
+    display_level(0); // the crying face is shown once the stage is left
+    status_set_remaining(0);
+    status_set_outcome(STATUS_OUTCOME_TIMEOUT);
+    audit_log(AUDIT_EVENT_TIMEOUT, stage);
+}
 
-    // show level of battery
-    display_level(level);
+// [Joystick Part]
+void handle_joystick_event(const struct gesture_event *ev)
+{
+    switch (ev->dir) {
+    case GESTURE_CENTER:
+        LOG_DBG("Center");
+        break;
+    case GESTURE_LEFT:
+        LOG_DBG("Left");
+        break;
+    case GESTURE_RIGHT:
+        LOG_DBG("Right");
+        break;
+    case GESTURE_UP:
+        LOG_DBG("Up");
+        break;
+    case GESTURE_DOWN:
+        LOG_DBG("Down");
+        break;
+    default:
+        break;
+    }
+    ui_show_arrow(ev->dir);
+
+    if (ev->dir == GESTURE_CENTER) {
+        return;
+    }
 
-    // time decrease
-    if (stage == 1 && seconds_count == 10) {
-        seconds--;
-        seconds_count = 0;
+    // the countdown starts with the first move
+    if (!flag_joystick_moved) {
+        countdown_start();
+        update_battery_display(countdown_remaining_ms());
+        status_set_remaining(COUNTDOWN_SECONDS);
     }
+    flag_joystick_moved = true;
 
-    if (stage == 2) {
-        seconds--;
+    // moves during a result face are not entered
+    if (ui_busy()) {
+        return;
     }
 
-    if (seconds < 0) {
-        time_out = true;
-        display_not_success();
-        strncpy(custom_message_value, "time out", CUSTOM_MESSAGE_MAX_LEN); // send "time out" to app
+    // only a move straight out of the center enters a digit
+    if (ev->entry && saved_index_joystick < MAX_SAVED_NUMBERS) {
+        saved_number_joystick[saved_index_joystick++] = ev->dir;
+        status_set_digits(saved_index_joystick);
     }
+}
+
+// Keeps the event queue drained until the face shown last has been up for
+// UI_FEEDBACK_MS. EVENT_UI only wakes main(), the wait timeout covers a
+// dropped one.
+static void wait_feedback_ended(void)
+{
+    struct app_event ev;
+
+    while (ui_feedback_ended() == UI_FEEDBACK_NONE) {
+        if (app_event_wait(&ev, K_MSEC(UI_FEEDBACK_MS)) == 0) {
+            app_event_done(&ev);
+        }
+    }
+}
+
+// [Event Sources]
+#define METRICS_PERIOD_S 10
+
+static uint32_t tick_count;
+
+static void handle_tick(int32_t remaining_ms)
+{
+    update_battery_display(remaining_ms);
+    status_set_remaining(DIV_ROUND_UP(remaining_ms, MSEC_PER_SEC));
+    LOG_DBG("seconds: %d", DIV_ROUND_UP(remaining_ms, MSEC_PER_SEC));
 
-    seconds_count++;
+    if (++tick_count % METRICS_PERIOD_S == 0) {
+        app_event_print_stats();
+    }
 }
 
 int bluetooth = true; 
 
 int main(void)
 {
+    perf_init();
+
     if (bluetooth) { //connect to bluetooth
         start_bluetooth();
         bluetooth = false; //didn't need to connect again
     }
 
-    // [LED Part Initialize]
-    struct sensor_value val;
-    int rc;
-    const struct device *const dev = DEVICE_DT_GET(DT_ALIAS(qdec0));
+    // display and input bring-up overlap
+    k_thread_create(&display_boot_thread, display_boot_stack,
+                    K_THREAD_STACK_SIZEOF(display_boot_stack), display_boot, NULL, NULL, NULL,
+                    K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
 
-    if (!device_is_ready(dev)) {
-        printk("Qdec device is not ready\n");
+    // [LED Part Initialize]
+    // encoder and its switch
+    if (rotary_init() < 0) {
         return 0;
     }
 
-    if (!device_is_ready(sw.port)) {
-        printk("SW GPIO is not ready\n");
+    // [Joystick Part Initialize]
+    if (joystick_init() < 0) {
+        LOG_ERR("Joystick init failed");
         return 0;
     }
 
-    int err = gpio_pin_configure_dt(&sw, GPIO_INPUT | GPIO_PULL_UP);
-    if (err < 0) {
-        printk("Error configuring SW GPIO pin %d\n", err);
+    // arrows are drawn from the first joystick event on
+    k_thread_join(&display_boot_thread, K_FOREVER);
+    if (display_boot_err < 0) {
         return 0;
     }
 
-    gpio_init_callback(&sw_cb_data, sw_callback, BIT(sw.pin));
-    err = gpio_add_callback(sw.port, &sw_cb_data);
-    if (err < 0) {
-        printk("Error adding callback for SW GPIO pin %d\n", err);
+    // both axes are sampled in the background from here on
+    if (joystick_start() < 0) {
         return 0;
     }
+    boot_input_ready_ms = k_uptime_get_32();
+    print_boot_report();
 
-    err = gpio_pin_interrupt_configure_dt(&sw, GPIO_INT_EDGE_TO_ACTIVE);
-    if (err != 0) {
-        printk("Error configuring SW GPIO interrupt %d\n", err);
-        return 0;
+    // attempt history survives resets, a missing log does not lock the safe
+    if (audit_init() < 0) {
+        LOG_ERR("Audit log init failed");
     }
 
-    // [Joystick Part Initialize]
-    uint32_t count = 0;
-    uint16_t buf;
-    struct adc_sequence sequence = {
-        .buffer = &buf,
-        /* buffer size in bytes, not number of samples */
-        .buffer_size = sizeof(buf),
-    };
-
-    /* Configure channels individually prior to sampling. */
-    for (size_t i = 0U; i < ARRAY_SIZE(adc_channels); i++) {
-        if (!adc_is_ready_dt(&adc_channels[i])) {
-            printk("ADC controller device %s not ready\n", adc_channels[i].dev->name);
-            return 0;
-        }
+    // Stage 1. Password by Joystick
+    enter_stage(STATUS_STAGE_JOYSTICK);
 
-        err = adc_channel_setup_dt(&adc_channels[i]);
-        if (err < 0) {
-            printk("Could not setup channel #%d (%d)\n", i, err);
-            return 0;
+    // main() sleeps until an event arrives, no polling period
+    while (1) {
+        struct app_event ev;
+
+        app_event_wait(&ev, K_FOREVER);
+
+        if (ui_feedback_ended() == UI_FEEDBACK_JOYSTICK_OK) { // smile shown long enough
+            led_clear();
+            app_event_done(&ev);
+            break;
         }
-    }
 
-    // I2C Matrix initialize
-    if (led_init() < 0) {
-        printk("LED init failed\n");
-        return 0;
-    }
-  
-    // battery display initialize
-    if (batterydisplay_init() < 0) {
-        printk("Battery display init failed\n");
-        return 0;
-    }
+        if (ev.type == EVENT_JOYSTICK) {
+            if (!boot_first_input_ms) {
+                boot_first_input_ms = k_uptime_get_32();
+            }
+            handle_joystick_event(&ev.gesture);
+        } else if (ev.type == EVENT_TICK) {
+            if (flag_joystick_moved == true) {
+                handle_tick(ev.remaining_ms);
+            }
+        } else if (ev.type == EVENT_TIMEOUT) {
+            handle_timeout();
+        } else if (ev.type == EVENT_UI) {
+            ui_handle_event(&ev);
+        }
 
-    // Stage 1. Password by Joystick
-    while (1) {
-        //printk("ADC reading[%u]: ", count++);
+        // the result face stays up for UI_FEEDBACK_MS while events keep flowing
+        if (saved_index_joystick == MAX_SAVED_NUMBERS) {
+            if (compare_arrays(saved_number_joystick, password_joystick, MAX_SAVED_NUMBERS)) {
+                ui_show_feedback(UI_FEEDBACK_JOYSTICK_OK);
+                audit_log(AUDIT_EVENT_ATTEMPT_OK, stage);
+            }
+            else {
+                ui_show_feedback(UI_FEEDBACK_JOYSTICK_FAIL);
+                audit_log(AUDIT_EVENT_ATTEMPT_FAIL, stage);
+            }
+            status_add_attempt();
+            saved_index_joystick = 0;
+            status_set_digits(0);
+        }
 
-        (void)adc_sequence_init_dt(&adc_channels[0], &sequence);
-        err = adc_read(adc_channels[0].dev, &sequence);
-        if (err < 0) {
-            printk("Could not read (%d)\n", err);
-            continue;
+        // EVENT_TIMEOUT can be dropped by a full queue, the latch cannot
+        if (countdown_expired()) {
+            handle_timeout();
         }
 
-        nowX = (int32_t)buf;
+        app_event_done(&ev);
 
-        (void)adc_sequence_init_dt(&adc_channels[1], &sequence);
-        err = adc_read(adc_channels[1].dev, &sequence);
-        if (err < 0) {
-            printk("Could not read (%d)\n", err);
-            continue;
+        if (time_out) {
+            strncpy(custom_message_value, "someone failed to unlock your safe", CUSTOM_MESSAGE_MAX_LEN);
+            break;
         }
+    }
 
-        nowY = (int32_t)buf;
+    joystick_stop();
+    ui_cancel();
 
-        //printk("Joy X: %" PRIu32 ", ", nowX);
-        //printk("Joy Y: %" PRIu32 ", ", nowY);
+    // a timeout in stage 1 skips straight to the final message
+    if (!time_out) {
+        LOG_INF("Quadrature decoder sensor test");
 
-        if (flag_joystick_moved == true) {
-            strncpy(custom_message_value, "Your safe is being opened(joystick)", CUSTOM_MESSAGE_MAX_LEN); // 
-            update_battery_display(1);
-            printk("seconds: %d\n", seconds);
-        }
+        led_on_idx(rotary_idx, LEFT);
+        rotary_start();
+        enter_stage(STATUS_STAGE_ROTARY);
+    }
 
-        if (nowX >= 65500 || nowY >= 65500){
-            printk("Out of Range\n");
-            k_sleep(K_MSEC(100));
-            continue;
-        }
+    // Stage 2. Password by Rotary Encoder
+    while (!time_out && !success) {
+        struct app_event ev;
 
-        bool checkFlag = isChange();
-        if(!checkFlag){
-            //printk("No Change\n");
-            k_sleep(K_MSEC(100));
-            continue;
-        } else {
-            led_off_all();
-        }
+        app_event_wait(&ev, K_FOREVER);
 
-        if (nowX == ADC_MAX && nowY == ADC_MAX){
-            led_on_center();
-            flag_joystick = true;
-            printk("Center");
-        } else if (nowX < AXIS_DEVIATION && nowY == ADC_MAX){
-            led_on_left();
+        enum ui_feedback ended = ui_feedback_ended();
 
-            if (flag_joystick) {
-                saved_number_joystick[saved_index_joystick++] = 4;
+        if (ended == UI_FEEDBACK_CODE_OK) { // smile shown long enough, on to the keypad
+            success = true;
+            app_event_done(&ev);
+            break;
+        }
+        if (ended == UI_FEEDBACK_CODE_FAIL) { // cleared before any new input is drawn
+            reset_rotary_display();
+        }
+
+        if (ev.type == EVENT_ROTATION && !ui_busy()) { // Display current rotary pattern on the left side
+            if (!digit_entry_running) {
+                digit_entry_start = ev.timestamp;
+                digit_entry_running = true;
             }
-            flag_joystick = false;
-            flag_joystick_moved = true;
-            printk("Left");
-        } else if (nowX > AXIS_DEVIATION && nowY == ADC_MAX) {
-            led_on_right();
-            if (flag_joystick) {
-                saved_number_joystick[saved_index_joystick++] = 2;
+            if (!code_entry_running) {
+                code_entry_start = ev.timestamp;
+                code_entry_running = true;
             }
-            flag_joystick = false;
-            flag_joystick_moved = true;
-            printk("Right");
-        } else if (nowY > AXIS_DEVIATION && nowX == ADC_MAX){
-            led_on_up();
-
-            if (flag_joystick) {
-                saved_number_joystick[saved_index_joystick++] = 1;
+            display_rotary_led(ev.rotation);
+            LOG_DBG("current value: %d", rotary_idx);
+        } else if (ev.type == EVENT_SWITCH && !ui_busy()) { // Display selected number on the right side
+            handle_switch_press();
+            led_on_idx(rotary_idx, RIGHT);
+
+            if (digit_entry_running) {
+                perf_stop(&digit_entry_stat, digit_entry_start);
+                digit_entry_running = false;
             }
-            flag_joystick = false;
-            flag_joystick_moved = true;
-            printk("Up");
-        } else if (nowY < AXIS_DEVIATION && nowX == ADC_MAX){
-            led_on_down();
-
-            if (flag_joystick) {
-                saved_number_joystick[saved_index_joystick++] = 3;
+            if (saved_index == MAX_SAVED_NUMBERS && code_entry_running) {
+                perf_stop(&code_entry_stat, code_entry_start);
+                code_entry_running = false;
             }
-            flag_joystick = false;
-            flag_joystick_moved = true;
-            printk("Down");
+        } else if (ev.type == EVENT_TICK) {
+            // update battery level
+            handle_tick(ev.remaining_ms);
+        } else if (ev.type == EVENT_TIMEOUT) {
+            handle_timeout();
+        } else if (ev.type == EVENT_UI) {
+            ui_handle_event(&ev);
         }
-        
-        if (saved_index_joystick == MAX_SAVED_NUMBERS) {
-            if (compare_arrays(saved_number_joystick, password_joystick, MAX_SAVED_NUMBERS)) {
-                led_off_all();
-                display_success();
-                k_msleep(3000);
-                led_off_all();
-                strncpy(custom_message_value, "Joystick success", CUSTOM_MESSAGE_MAX_LEN);
-                break;
-            }
-            else {
-                led_off_all();
-                display_not_success();
-                k_msleep(3000);
-                saved_index_joystick = 0;
-            }
+
+        if (saved_index == 4) {
+            check_password_matching();
+        }
+
+        if (countdown_expired()) {
+            handle_timeout();
         }
-      
-        printk("\n");
 
+        app_event_done(&ev);
+
+        // termination condition
         if (time_out) {
-            display_not_success();
             strncpy(custom_message_value, "someone failed to unlock your safe", CUSTOM_MESSAGE_MAX_LEN);
             break;
         }
+    }
+
+    rotary_stop();
+    ui_cancel();
 
-        k_sleep(K_MSEC(100));
+    // Stage 3. Password by Keypad
+    // keys arrive from the HT16K33 INT line through the same event queue
+    if (success) {
+        led_clear();
+        enter_stage(STATUS_STAGE_KEYPAD);
     }
 
-    printk("Quadrature decoder sensor test\n");
-    
-    led_on_idx(rotary_idx, LEFT);
+    while (success && !keypad_success) {
+        struct app_event ev;
 
-    // Stage 2. Password by Rotary Encoder
-    while (true) {
-        rc = sensor_sample_fetch(dev);
-        if (rc != 0) {
-            printk("Failed to fetch sample (%d)\n", rc);
-            return 0;
-        }
+        app_event_wait(&ev, K_FOREVER);
 
-        rc = sensor_channel_get(dev, SENSOR_CHAN_ROTATION, &val);
-        if (rc != 0) {
-            printk("Failed to get data (%d)\n", rc);
-            return 0;
+        if (ui_feedback_ended() == UI_FEEDBACK_KEYPAD_FAIL) {
+            led_clear();
         }
 
-        if (!sw_led_flag) { // Display current rotary pattern on the left side
-            display_rotary_led(val.val1);
-        } else { // Display selected number on the right side
-            display_pattern(led_patterns[rotary_idx], RIGHT);
-            sw_led_flag = false; // Reset flag to allow continuous update
+        if (ev.type == EVENT_KEY) {
+            handle_key(ev.key);
+        } else if (ev.type == EVENT_TICK) {
+            handle_tick(ev.remaining_ms);
+        } else if (ev.type == EVENT_TIMEOUT) {
+            handle_timeout();
+        } else if (ev.type == EVENT_UI) {
+            ui_handle_event(&ev);
         }
 
-        printk("current value: %d\n", rotary_idx);
-
-        if (flag_password_moved == true) {
-            strncpy(custom_message_value, "Your safe is being opened(password)", CUSTOM_MESSAGE_MAX_LEN);
+        if (saved_index_keypad == MAX_SAVED_NUMBERS) {
+            check_keypad_matching();
         }
 
-        // update battery level
-        update_battery_display(2);
-        printk("seconds: %d\n", seconds);
-
-        if (saved_index == 4) {
-            check_password_matching();
+        if (countdown_expired()) {
+            handle_timeout();
         }
 
-        // termination condition
+        app_event_done(&ev);
+
         if (time_out) {
-            display_not_success();
             strncpy(custom_message_value, "someone failed to unlock your safe", CUSTOM_MESSAGE_MAX_LEN);
             break;
         }
+    }
 
-        if (success) {
-            break;
-        }
+    countdown_stop();
 
-        k_msleep(1000);
+    if (!time_out) {
+        strncpy(custom_message_value, "Your safe is opened!", CUSTOM_MESSAGE_MAX_LEN);
+        status_set_outcome(STATUS_OUTCOME_OPENED);
+        audit_log(AUDIT_EVENT_OPENED, stage);
     }
-
-    strncpy(custom_message_value, "Your safe is opened!", CUSTOM_MESSAGE_MAX_LEN);
+    enter_stage(STATUS_STAGE_DONE);
+    audit_commit();
+
+    // the result face replaces whatever the last stage left on the matrix
+    ui_show_feedback(time_out ? UI_FEEDBACK_TIMEOUT : UI_FEEDBACK_OPENED);
+    wait_feedback_ended();
+
+    // the final status is also shown on the matrix, not only over BLE
+    text_scroll(custom_message_value, true);
+
+    print_boot_report();
+    perf_print(&digit_entry_stat);
+    perf_print(&code_entry_stat);
+    led_print_stats();
+    app_event_print_stats();
+    batterydisplay_print_stats();
+    rotary_print_stats();
+    countdown_print_stats();
+    keypad_print_stats();
+    text_print_stats();
+    anim_print_stats();
+    status_print_stats();
+    telemetry_print_stats();
+    audit_print_stats();
 
     return 0;
 }
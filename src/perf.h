@@ -0,0 +1,115 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/timing/timing.h>
+
+// Measurement points and the [perf] reports are only built with
+// CONFIG_SAFE_PERF=y, a release build carries none of them.
+#ifndef PERF_ENABLED
+#ifdef CONFIG_SAFE_PERF
+#define PERF_ENABLED 1
+#else
+#define PERF_ENABLED 0
+#endif
+#endif
+
+// Cycle-counter statistics for one measured code path.
+// Plain stats use k_cycle_get_32() (system timer, 32 kHz on nRF52) and may span
+// seconds. Hires stats use the CPU cycle counter for sub-microsecond paths
+// such as ISRs, and must stay well below its wrap time.
+struct perf_stat {
+    const char *name;
+    bool hires;
+    uint32_t count;
+    uint32_t last_cyc;
+    uint32_t max_cyc;
+    uint64_t total_cyc;
+};
+
+#define PERF_STAT_DEFINE(var, label) struct perf_stat var = { .name = label }
+#define PERF_STAT_DEFINE_HIRES(var, label) struct perf_stat var = { .name = label, .hires = true }
+
+// Start the CPU cycle counter used by the hires stats, once at boot
+static inline void perf_init(void)
+{
+#if PERF_ENABLED
+    timing_init();
+    timing_start();
+#endif
+}
+
+static inline uint32_t perf_start(void)
+{
+#if PERF_ENABLED
+    return k_cycle_get_32();
+#else
+    return 0;
+#endif
+}
+
+static inline uint32_t perf_start_hires(void)
+{
+#if PERF_ENABLED
+    return (uint32_t)timing_counter_get();
+#else
+    return 0;
+#endif
+}
+
+// Pairs with perf_start() or perf_start_hires(), whichever matches the stat
+static inline void perf_stop(struct perf_stat *stat, uint32_t start)
+{
+#if PERF_ENABLED
+    uint32_t now = stat->hires ? (uint32_t)timing_counter_get() : k_cycle_get_32();
+    uint32_t cyc = now - start;
+
+    stat->count++;
+    stat->last_cyc = cyc;
+    stat->total_cyc += cyc;
+    if (cyc > stat->max_cyc) {
+        stat->max_cyc = cyc;
+    }
+#endif
+}
+
+static inline void perf_reset(struct perf_stat *stat)
+{
+    stat->count = 0;
+    stat->last_cyc = 0;
+    stat->max_cyc = 0;
+    stat->total_cyc = 0;
+}
+
+static inline uint32_t perf_cyc_to_ns(const struct perf_stat *stat, uint32_t cyc)
+{
+#if PERF_ENABLED
+    if (stat->hires) {
+        return (uint32_t)timing_cycles_to_ns(cyc);
+    }
+    return k_cyc_to_us_floor32(cyc) * 1000U;
+#else
+    return 0;
+#endif
+}
+
+static inline void perf_print(const struct perf_stat *stat)
+{
+#if PERF_ENABLED
+    uint32_t avg = stat->count ? (uint32_t)(stat->total_cyc / stat->count) : 0;
+
+    if (stat->hires) {
+        printk("[perf] %s: n=%u last=%uns avg=%uns max=%uns\n", stat->name, stat->count,
+               perf_cyc_to_ns(stat, stat->last_cyc), perf_cyc_to_ns(stat, avg),
+               perf_cyc_to_ns(stat, stat->max_cyc));
+        return;
+    }
+
+    printk("[perf] %s: n=%u last=%uus avg=%uus max=%uus\n", stat->name, stat->count,
+           k_cyc_to_us_floor32(stat->last_cyc), k_cyc_to_us_floor32(avg),
+           k_cyc_to_us_floor32(stat->max_cyc));
+#endif
+}
+
+#endif // PERF_H
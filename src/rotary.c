@@ -0,0 +1,203 @@
+#include <stdlib.h>
+
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include "rotary.h"
+#include "events.h"
+#include "telemetry.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(rotary, CONFIG_SAFE_ROTARY_LOG_LEVEL);
+
+#define UDEG_PER_DEGREE 1000000LL
+#define DETENT_UDEG (360 * UDEG_PER_DEGREE / ROTARY_STEPS)
+
+static const struct device *const qdec = DEVICE_DT_GET(DT_ALIAS(qdec0));
+static const struct gpio_dt_spec sw = GPIO_DT_SPEC_GET(ROTARY_SW_NODE, gpios);
+static struct gpio_callback sw_cb_data;
+
+static const struct sensor_trigger qdec_trigger = {
+    .type = SENSOR_TRIG_DATA_READY,
+    .chan = SENSOR_CHAN_ROTATION,
+};
+
+struct accel_point {
+    uint16_t min_dps;
+    uint8_t step;
+};
+
+static const struct accel_point accel_curve[] = { ROTARY_ACCEL_CURVE };
+
+// Rotation not yet converted into whole detents, in micro-degrees. Only the
+// remainder stays here, so no movement is ever lost between reports.
+static int64_t residual_udeg;
+static uint32_t last_report_ms;
+
+// First edge of the current bounce burst and the edges in it, set by the ISR
+// and taken by the settle work. Bit 0 of the timestamp is forced to 1 so a
+// recorded edge is never 0, which means none.
+static atomic_t sw_first_edge;
+static atomic_t sw_burst_edges;
+
+static bool sw_pressed; // debounced level, work queue only
+static uint32_t sw_edges, sw_presses;
+
+static PERF_STAT_DEFINE_HIRES(sw_isr_stat, "switch isr");
+
+static void sw_settle_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(sw_settle_work, sw_settle_handler);
+
+// Steps per detent for the measured detent velocity
+static int32_t accel_step(uint32_t dps)
+{
+    int32_t step = 1;
+
+    for (size_t i = 0; i < ARRAY_SIZE(accel_curve); i++) {
+        if (dps >= accel_curve[i].min_dps) {
+            step = MIN(accel_curve[i].step, ROTARY_ACCEL_MAX_STEP);
+        }
+    }
+    return step;
+}
+
+// Runs in the QDEC interrupt whenever the peripheral reports movement
+static void qdec_data_ready(const struct device *dev, const struct sensor_trigger *trig)
+{
+    struct sensor_value val;
+
+    if (sensor_sample_fetch(dev) != 0 ||
+        sensor_channel_get(dev, SENSOR_CHAN_ROTATION, &val) != 0) {
+        return;
+    }
+
+    telemetry_record(TELEMETRY_SRC_QDEC, val.val1, val.val2 / 100);
+    residual_udeg += val.val1 * UDEG_PER_DEGREE + val.val2;
+
+    int32_t detents = residual_udeg / DETENT_UDEG;
+    if (detents == 0) {
+        return;
+    }
+    residual_udeg -= detents * DETENT_UDEG;
+
+    // velocity from the detents in this report and the time since the previous one
+    uint32_t now = k_uptime_get_32();
+    uint32_t dt = now - last_report_ms;
+    uint32_t dps = 0;
+
+    last_report_ms = now;
+    if (dt < ROTARY_IDLE_MS) {
+        dps = (uint32_t)abs(detents) * 1000U / MAX(dt, 1U);
+    }
+
+    struct app_event ev = { .type = EVENT_ROTATION, .rotation = detents * accel_step(dps) };
+
+    app_event_post(&ev);
+}
+
+// Runs in the GPIO interrupt on every edge of the switch, bounces included.
+// Only records when the edge happened, everything else waits for the work item.
+static void sw_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+    uint32_t start_cyc = perf_start_hires();
+
+    (void)atomic_cas(&sw_first_edge, 0, k_cycle_get_32() | 1);
+    atomic_inc(&sw_burst_edges);
+
+    // every edge pushes the settle check back, so it runs once the contacts are quiet
+    k_work_reschedule(&sw_settle_work, K_MSEC(ROTARY_SW_DEBOUNCE_MS));
+
+    perf_stop(&sw_isr_stat, start_cyc);
+}
+
+// The switch has been quiet for ROTARY_SW_DEBOUNCE_MS: sample the settled level
+// and report a press when it changed to active
+static void sw_settle_handler(struct k_work *work)
+{
+    uint32_t first_edge = atomic_set(&sw_first_edge, 0);
+
+    sw_edges += atomic_set(&sw_burst_edges, 0);
+
+    int level = gpio_pin_get_dt(&sw);
+    if (level < 0 || level == sw_pressed) {
+        return; // a glitch that settled back to the old level
+    }
+
+    sw_pressed = level;
+    if (sw_pressed) {
+        // latency is measured from the first edge of the burst, not from the end of the debounce
+        struct app_event ev = { .type = EVENT_SWITCH, .timestamp = first_edge };
+
+        sw_presses++;
+        app_event_post(&ev);
+    }
+}
+
+static int sw_init(void)
+{
+    if (!device_is_ready(sw.port)) {
+        LOG_ERR("SW GPIO is not ready");
+        return -1;
+    }
+
+    int err = gpio_pin_configure_dt(&sw, GPIO_INPUT | GPIO_PULL_UP);
+    if (err < 0) {
+        LOG_ERR("Error configuring SW GPIO pin %d", err);
+        return -1;
+    }
+
+    sw_pressed = gpio_pin_get_dt(&sw) > 0;
+
+    gpio_init_callback(&sw_cb_data, sw_isr, BIT(sw.pin));
+    err = gpio_add_callback(sw.port, &sw_cb_data);
+    if (err < 0) {
+        LOG_ERR("Error adding callback for SW GPIO pin %d", err);
+        return -1;
+    }
+
+    // both edges, the release has to be seen for the next press to count
+    err = gpio_pin_interrupt_configure_dt(&sw, GPIO_INT_EDGE_BOTH);
+    if (err != 0) {
+        LOG_ERR("Error configuring SW GPIO interrupt %d", err);
+        return -1;
+    }
+    return 0;
+}
+
+int rotary_init(void)
+{
+    if (!device_is_ready(qdec)) {
+        LOG_ERR("Qdec device is not ready");
+        return -1;
+    }
+    return sw_init();
+}
+
+int rotary_start(void)
+{
+    // drop whatever was turned before the rotary stage began
+    (void)sensor_sample_fetch(qdec);
+    residual_udeg = 0;
+    last_report_ms = k_uptime_get_32() - ROTARY_IDLE_MS;
+
+    int err = sensor_trigger_set(qdec, &qdec_trigger, qdec_data_ready);
+    if (err < 0) {
+        LOG_ERR("Could not set qdec trigger (%d)", err);
+    }
+    return err;
+}
+
+void rotary_stop(void)
+{
+    (void)sensor_trigger_set(qdec, &qdec_trigger, NULL);
+}
+
+void rotary_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] switch: %u presses from %u edges\n", sw_presses, sw_edges);
+    perf_print(&sw_isr_stat);
+#endif
+}
\ No newline at end of file
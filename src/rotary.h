@@ -0,0 +1,44 @@
+#ifndef ROTARY_H
+#define ROTARY_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+
+#if !DT_NODE_EXISTS(DT_ALIAS(qdec0))
+#error "Unsupported board: qdec0 devicetree alias is not defined"
+#endif
+
+// Encoder detents per revolution, from the qdec0 "steps" property
+#define ROTARY_STEPS DT_PROP(DT_ALIAS(qdec0), steps)
+
+// Acceleration curve: at or above min_dps detents per second, every detent moves
+// the selection by step. Entries must be sorted by min_dps, the first one keeps
+// slow turns at exactly one step per detent.
+#define ROTARY_ACCEL_CURVE \
+    { .min_dps = 0, .step = 1 }, \
+    { .min_dps = 12, .step = 2 }, \
+    { .min_dps = 25, .step = 3 }, \
+    { .min_dps = 50, .step = ROTARY_ACCEL_MAX_STEP }
+
+// Largest step per detent. On a ring of n digits a step of n/2 or more looks
+// like a turn the other way, users of the encoder must assert it stays below.
+#define ROTARY_ACCEL_MAX_STEP 4
+
+// A pause longer than this resets the measured velocity to zero
+#define ROTARY_IDLE_MS 150
+
+#define ROTARY_SW_NODE DT_NODELABEL(gpiosw)
+#if !DT_NODE_HAS_STATUS(ROTARY_SW_NODE, okay)
+#error "Unsupported board: gpiosw devicetree alias is not defined or enabled"
+#endif
+
+// The switch level must stay unchanged this long after the last edge to count
+#define ROTARY_SW_DEBOUNCE_MS 30
+
+int rotary_init(void);
+int rotary_start(void);
+void rotary_stop(void);
+void rotary_print_stats(void);
+
+#endif // ROTARY_H
\ No newline at end of file
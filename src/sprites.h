@@ -0,0 +1,79 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+// Sprite atlas of the I2C matrix. Rows are listed top to bottom, MSB = leftmost column.
+// SPRITE_8 entries are 8x8 and can be shown on the LEFT or RIGHT half,
+// SPRITE_16 entries cover the whole 16x8 matrix.
+// led.c encodes every entry into HT16K33 RAM images at compile time,
+// so a new icon only needs a new line here.
+#define LED_SPRITES(SPRITE_8, SPRITE_16) \
+    SPRITE_8(DIGIT_0, 0b11111111, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b10000001, 0b11111111) \
+    SPRITE_8(DIGIT_1, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000, 0b00010000) \
+    SPRITE_8(DIGIT_2, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b00000000) \
+    SPRITE_8(DIGIT_3, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000) \
+    SPRITE_8(DIGIT_4, 0b10000001, 0b10000001, 0b10000001, 0b11111111, 0b00000001, 0b00000001, 0b00000001, 0b00000000) \
+    SPRITE_8(DIGIT_5, 0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000) \
+    SPRITE_8(DIGIT_6, 0b11111111, 0b10000000, 0b10000000, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000000) \
+    SPRITE_8(DIGIT_7, 0b11111111, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000001, 0b00000000) \
+    SPRITE_8(DIGIT_8, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000000) \
+    SPRITE_8(DIGIT_9, 0b11111111, 0b10000001, 0b10000001, 0b11111111, 0b00000001, 0b00000001, 0b11111111, 0b00000000) \
+    /* when password get success (smile face) */ \
+    SPRITE_8(SMILE,   0b00000000, 0b01000010, 0b10100101, 0b00000000, 0b00000000, 0b01000010, 0b00111100, 0b00000000) \
+    /* when password fail (crying face) */ \
+    SPRITE_8(CRY,     0b00000000, 0b10100101, 0b01000010, 0b00000000, 0b00000000, 0b00111100, 0b01000010, 0b00000000) \
+    SPRITE_16(ARROW_CENTER, \
+        0b0000000000000000, \
+        0b0000000000000000, \
+        0b0000001111000000, \
+        0b0000001111000000, \
+        0b0000001111000000, \
+        0b0000001111000000, \
+        0b0000000000000000, \
+        0b0000000000000000) \
+    SPRITE_16(ARROW_RIGHT, \
+        0b0000000000000000, \
+        0b0000000000100000, \
+        0b0000001111110000, \
+        0b0000001111111100, \
+        0b0000001111111100, \
+        0b0000001111110000, \
+        0b0000000000100000, \
+        0b0000000000000000) \
+    SPRITE_16(ARROW_LEFT, \
+        0b0000000000000000, \
+        0b0000010000000000, \
+        0b0000111111000000, \
+        0b0011111111000000, \
+        0b0011111111000000, \
+        0b0000111111000000, \
+        0b0000010000000000, \
+        0b0000000000000000) \
+    SPRITE_16(ARROW_UP, \
+        0b0000000000000000, \
+        0b0000000110000000, \
+        0b0000011111100000, \
+        0b0000111111110000, \
+        0b0000001111000000, \
+        0b0000001111000000, \
+        0b0000000000000000, \
+        0b0000000000000000) \
+    SPRITE_16(ARROW_DOWN, \
+        0b0000000000000000, \
+        0b0000000000000000, \
+        0b0000001111000000, \
+        0b0000001111000000, \
+        0b0000111111110000, \
+        0b0000011111100000, \
+        0b0000000110000000, \
+        0b0000000000000000)
+
+#define SPRITE_ID(name, ...) SPRITE_##name,
+
+enum led_sprite_id {
+    LED_SPRITES(SPRITE_ID, SPRITE_ID)
+    SPRITE_COUNT
+};
+
+#define SPRITE_DIGIT(n) ((enum led_sprite_id)(SPRITE_DIGIT_0 + (n)))
+
+#endif // SPRITES_H
@@ -0,0 +1,225 @@
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+
+#include "status.h"
+#include "perf.h"
+
+#define ATT_NOTIFY_HEADER 3 // opcode + handle
+
+static struct bt_uuid_128 custom_service_uuid = BT_UUID_INIT_128(BT_UUID_CUSTOM_SERVICE_VAL);
+static struct bt_uuid_128 custom_status_uuid = BT_UUID_INIT_128(BT_UUID_CUSTOM_STATUS_VAL);
+
+// Host order copy of the fields, and the same record already encoded for reads
+static struct status_record state;
+static struct status_record encoded;
+
+static struct status_record pending[STATUS_PENDING_MAX];
+static uint8_t pending_count;
+static uint8_t notify_buf[STATUS_PENDING_MAX * sizeof(struct status_record)];
+static uint16_t att_mtu = BT_ATT_DEFAULT_LE_MTU;
+static bool notify_enabled;
+static struct k_spinlock lock;
+
+static struct status_adv adv_data = {
+    .company = sys_cpu_to_le16(STATUS_ADV_COMPANY_ID),
+};
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_CUSTOM_SERVICE_VAL),
+    BT_DATA(BT_DATA_MANUFACTURER_DATA, &adv_data, sizeof(adv_data)),
+};
+
+// each AD structure costs a length and a type byte on top of its data
+BUILD_ASSERT(3 + 18 + 2 + sizeof(struct status_adv) <= BT_GAP_ADV_MAX_ADV_DATA_LEN,
+             "status does not fit into the advertising data");
+
+static uint32_t changes, notifications, records_sent, superseded;
+static uint32_t adv_updates, adv_skipped;
+static PERF_STAT_DEFINE(adv_update_stat, "status adv update");
+
+static void notify_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(notify_work, notify_handler);
+
+static ssize_t read_status(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                           uint16_t len, uint16_t offset)
+{
+    struct status_record value;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    value = encoded;
+    k_spin_unlock(&lock, key);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &value, sizeof(value));
+}
+
+static void status_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    notify_enabled = (value == BT_GATT_CCC_NOTIFY);
+}
+
+// Custom Service Declaration
+BT_GATT_SERVICE_DEFINE(custom_svc,
+                       BT_GATT_PRIMARY_SERVICE(&custom_service_uuid),
+                       BT_GATT_CHARACTERISTIC(&custom_status_uuid.uuid,
+                                              BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                                              BT_GATT_PERM_READ,
+                                              read_status, NULL, NULL),
+                       BT_GATT_CCC(status_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE));
+
+// Encode the current state once per change and queue it for notification.
+// Called with lock held, releases it.
+static void commit(k_spinlock_key_t key)
+{
+    struct status_record next = {
+        .seq = encoded.seq,
+        .stage = state.stage,
+        .digits = state.digits,
+        .outcome = state.outcome,
+        .remaining_s = sys_cpu_to_le16(state.remaining_s),
+        .attempts = sys_cpu_to_le16(state.attempts),
+    };
+
+    if (memcmp(&next, &encoded, sizeof(next)) == 0) {
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    next.seq++;
+    encoded = next;
+    changes++;
+
+    if (pending_count == STATUS_PENDING_MAX) {
+        memmove(&pending[0], &pending[1], sizeof(pending) - sizeof(pending[0]));
+        pending_count--;
+        superseded++;
+    }
+    pending[pending_count++] = next;
+    k_spin_unlock(&lock, key);
+
+    // the first change of a burst opens the window, later ones join it
+    k_work_schedule(&notify_work, K_MSEC(STATUS_NOTIFY_DELAY_MS));
+}
+
+static void fill_adv(const struct status_record *rec)
+{
+    adv_data.state = rec->stage | (rec->outcome << 4);
+    adv_data.seq = rec->seq;
+    adv_data.remaining_s = rec->remaining_s;
+    adv_data.attempts = MIN(sys_le16_to_cpu(rec->attempts), UINT8_MAX);
+}
+
+// Rewrite the manufacturer data in place, advertising keeps running. While a
+// connection has paused advertising the update fails, the next change catches up.
+static void update_adv(const struct status_record *rec)
+{
+    fill_adv(rec);
+
+    uint32_t start = perf_start();
+    int err = bt_le_adv_update_data(ad, ARRAY_SIZE(ad), NULL, 0);
+
+    if (err < 0) {
+        adv_skipped++;
+        return;
+    }
+    perf_stop(&adv_update_stat, start);
+    adv_updates++;
+}
+
+// Send the newest pending records that fit into one notification, and the
+// newest state to the advertising data
+static void notify_handler(struct k_work *work)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    struct status_record latest = encoded;
+    size_t fit = MAX((att_mtu - ATT_NOTIFY_HEADER) / sizeof(struct status_record), 1);
+    size_t n = MIN(pending_count, fit);
+
+    memcpy(notify_buf, &pending[pending_count - n], n * sizeof(struct status_record));
+    superseded += pending_count - n;
+    pending_count = 0;
+    k_spin_unlock(&lock, key);
+
+    update_adv(&latest);
+
+    if (!notify_enabled || n == 0) {
+        return;
+    }
+
+    if (bt_gatt_notify(NULL, &custom_svc.attrs[1], notify_buf,
+                       n * sizeof(struct status_record)) == 0) {
+        notifications++;
+        records_sent += n;
+    }
+}
+
+void status_set_stage(enum status_stage stage)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state.stage = stage;
+    state.digits = 0;
+    commit(key);
+}
+
+void status_set_digits(uint8_t digits)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state.digits = digits;
+    commit(key);
+}
+
+void status_set_remaining(uint16_t remaining_s)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state.remaining_s = remaining_s;
+    commit(key);
+}
+
+void status_set_outcome(enum status_outcome outcome)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state.outcome = outcome;
+    commit(key);
+}
+
+// One more complete code entered, right or wrong
+void status_add_attempt(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    state.attempts++;
+    commit(key);
+}
+
+// ATT MTU of the connection, from the att_mtu_updated callback
+void status_set_mtu(uint16_t mtu)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    att_mtu = mtu;
+    k_spin_unlock(&lock, key);
+}
+
+// Connectable advertising with the status in the manufacturer data, the name
+// goes into the scan response
+int status_adv_start(void)
+{
+    fill_adv(&encoded);
+    return bt_le_adv_start(BT_LE_ADV_CONN_NAME, ad, ARRAY_SIZE(ad), NULL, 0);
+}
+
+void status_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] status: %u changes, %u notifications, %u records sent, %u superseded, mtu %u\n",
+           changes, notifications, records_sent, superseded, att_mtu);
+    printk("[perf] status adv: %u updates, %u skipped while paused\n", adv_updates, adv_skipped);
+    perf_print(&adv_update_stat);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/uuid.h>
+
+// Custom safe service and its binary status characteristic
+#define BT_UUID_CUSTOM_SERVICE_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef0)
+
+#define BT_UUID_CUSTOM_STATUS_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef6)
+
+// Bluetooth SIG company ID reserved for testing, replace with an assigned one
+#define STATUS_ADV_COMPANY_ID 0xFFFF
+
+// Changes within this window go out as one notification
+#define STATUS_NOTIFY_DELAY_MS 50
+// Records kept for the next notification, older ones are superseded
+#define STATUS_PENDING_MAX 8
+
+enum status_stage {
+    STATUS_STAGE_IDLE,
+    STATUS_STAGE_JOYSTICK,
+    STATUS_STAGE_ROTARY,
+    STATUS_STAGE_KEYPAD,
+    STATUS_STAGE_DONE,
+};
+
+enum status_outcome {
+    STATUS_OUTCOME_PENDING,
+    STATUS_OUTCOME_OPENED,
+    STATUS_OUTCOME_TIMEOUT,
+};
+
+// Wire format, little endian. A notification carries one or more records,
+// oldest first; seq counts changes so the phone can tell how many were merged.
+struct status_record {
+    uint8_t seq;
+    uint8_t stage;
+    uint8_t digits;
+    uint8_t outcome;
+    uint16_t remaining_s;
+    uint16_t attempts;
+} __packed;
+
+// Manufacturer specific advertising data, little endian, for observers that
+// never connect. It has to fit next to the flags and the 128-bit service UUID.
+struct status_adv {
+    uint16_t company;
+    uint8_t state; // stage in the low nibble, outcome in the high nibble
+    uint8_t seq;
+    uint16_t remaining_s;
+    uint8_t attempts; // saturates at 255
+} __packed;
+
+int status_adv_start(void);
+void status_set_stage(enum status_stage stage);
+void status_set_digits(uint8_t digits);
+void status_set_remaining(uint16_t remaining_s);
+void status_set_outcome(enum status_outcome outcome);
+void status_add_attempt(void);
+void status_set_mtu(uint16_t mtu);
+void status_print_stats(void);
+
+#endif // STATUS_H
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include "telemetry.h"
+#include "cts.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(telemetry, CONFIG_SAFE_TELEMETRY_LOG_LEVEL);
+
+BUILD_ASSERT(IS_POWER_OF_TWO(TELEMETRY_RING_SIZE), "ring size must be a power of two");
+
+#define ATT_NOTIFY_HEADER 3 // opcode + handle
+
+static struct bt_uuid_128 telemetry_service_uuid = BT_UUID_INIT_128(BT_UUID_TELEMETRY_SERVICE_VAL);
+static struct bt_uuid_128 telemetry_stream_uuid = BT_UUID_INIT_128(BT_UUID_TELEMETRY_STREAM_VAL);
+
+// Filled from the ADC and QDEC interrupts, drained by the telemetry thread
+static struct telemetry_sample ring[TELEMETRY_RING_SIZE];
+static uint32_t ring_head, ring_tail;
+static uint8_t seq;
+static struct k_spinlock lock;
+static K_SEM_DEFINE(batch_ready, 0, 1);
+
+static atomic_t streaming;
+static uint16_t att_mtu = BT_ATT_DEFAULT_LE_MTU;
+static struct bt_conn *current_conn;
+static uint8_t notify_buf[TELEMETRY_NOTIFY_MAX];
+
+static uint32_t recorded, dropped, sent_samples, sent_bytes, notifications, notify_errors;
+static int64_t stream_start, stream_ms;
+
+static void conn_tune_handler(struct k_work *work);
+static K_WORK_DEFINE(conn_tune_work, conn_tune_handler);
+
+static size_t samples_per_notify(void)
+{
+    uint16_t payload = MIN(att_mtu - ATT_NOTIFY_HEADER, TELEMETRY_NOTIFY_MAX);
+
+    return MAX(payload / sizeof(struct telemetry_sample), 1);
+}
+
+void telemetry_record(enum telemetry_source source, int16_t a, int16_t b)
+{
+    if (!atomic_get(&streaming)) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t count = ring_head - ring_tail;
+
+    // the sequence number still advances, so the phone sees the gap
+    seq++;
+    recorded++;
+    if (count == TELEMETRY_RING_SIZE) {
+        dropped++;
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    ring[ring_head & (TELEMETRY_RING_SIZE - 1)] = (struct telemetry_sample){
+        .time_ms = sys_cpu_to_le16((uint16_t)cts_now_ms()),
+        .source = source,
+        .seq = seq,
+        .a = sys_cpu_to_le16(a),
+        .b = sys_cpu_to_le16(b),
+    };
+    ring_head++;
+    k_spin_unlock(&lock, key);
+
+    if (count + 1 == samples_per_notify()) {
+        k_sem_give(&batch_ready);
+    }
+}
+
+// Copy up to max samples out of the ring
+static size_t take_samples(struct telemetry_sample *out, size_t max)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    size_t n = MIN(ring_head - ring_tail, max);
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ring[(ring_tail + i) & (TELEMETRY_RING_SIZE - 1)];
+    }
+    ring_tail += n;
+    k_spin_unlock(&lock, key);
+
+    return n;
+}
+
+static void telemetry_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    bool enable = (value == BT_GATT_CCC_NOTIFY);
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (enable == (bool)atomic_get(&streaming)) {
+        k_spin_unlock(&lock, key);
+        return;
+    }
+
+    // samples left over from an earlier stream are stale
+    ring_tail = ring_head;
+    atomic_set(&streaming, enable);
+    k_spin_unlock(&lock, key);
+
+    if (enable) {
+        stream_start = k_uptime_get();
+        k_work_submit(&conn_tune_work);
+        k_sem_give(&batch_ready); // wakes the thread into its timed flush
+    } else {
+        stream_ms += k_uptime_get() - stream_start;
+    }
+}
+
+BT_GATT_SERVICE_DEFINE(telemetry_svc,
+                       BT_GATT_PRIMARY_SERVICE(&telemetry_service_uuid),
+                       BT_GATT_CHARACTERISTIC(&telemetry_stream_uuid.uuid,
+                                              BT_GATT_CHRC_NOTIFY,
+                                              BT_GATT_PERM_NONE,
+                                              NULL, NULL, NULL),
+                       BT_GATT_CCC(telemetry_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE));
+
+// Only asked for once a client opts in, an idle connection keeps the central's
+// slower defaults. Each request is answered by the matching callback below.
+static void conn_tune_handler(struct k_work *work)
+{
+    int err;
+
+    if (!current_conn) {
+        return;
+    }
+
+    err = bt_conn_le_data_len_update(current_conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (err < 0) {
+        LOG_ERR("data length update failed (%d)", err);
+    }
+
+    err = bt_conn_le_phy_update(current_conn, BT_CONN_LE_PHY_PARAM_2M);
+    if (err < 0) {
+        LOG_ERR("PHY update failed (%d)", err);
+    }
+
+    err = bt_conn_le_param_update(current_conn, TELEMETRY_CONN_PARAM);
+    if (err < 0) {
+        LOG_ERR("connection parameter update failed (%d)", err);
+    }
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    if (!err && !current_conn) {
+        current_conn = bt_conn_ref(conn);
+    }
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    if (conn != current_conn) {
+        return;
+    }
+
+    bt_conn_unref(current_conn);
+    current_conn = NULL;
+    att_mtu = BT_ATT_DEFAULT_LE_MTU;
+    telemetry_ccc_cfg_changed(NULL, 0);
+}
+
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                             uint16_t timeout)
+{
+    LOG_INF("interval %u.%02u ms latency %u timeout %u ms", interval * 125 / 100,
+            interval * 125 % 100, latency, timeout * 10);
+}
+
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+    LOG_INF("PHY tx %u rx %u", param->tx_phy, param->rx_phy);
+}
+
+static void le_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info)
+{
+    LOG_INF("data length tx %u rx %u bytes", info->tx_max_len, info->rx_max_len);
+}
+
+BT_CONN_CB_DEFINE(telemetry_conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .le_param_updated = le_param_updated,
+    .le_phy_updated = le_phy_updated,
+    .le_data_len_updated = le_data_len_updated,
+};
+
+// Sends full notifications as soon as they are available and whatever is
+// left every TELEMETRY_FLUSH_MS. bt_gatt_notify() blocks here, not in the
+// producers, while the controller has no free buffers. Without a subscriber
+// the thread sleeps until notifications are enabled.
+static void telemetry_thread(void *p1, void *p2, void *p3)
+{
+    while (1) {
+        k_timeout_t flush = atomic_get(&streaming) ? K_MSEC(TELEMETRY_FLUSH_MS) : K_FOREVER;
+
+        (void)k_sem_take(&batch_ready, flush);
+
+        while (atomic_get(&streaming)) {
+            size_t n = take_samples((struct telemetry_sample *)notify_buf, samples_per_notify());
+
+            if (n == 0) {
+                break;
+            }
+
+            uint16_t len = n * sizeof(struct telemetry_sample);
+
+            if (bt_gatt_notify(NULL, &telemetry_svc.attrs[1], notify_buf, len) < 0) {
+                k_spinlock_key_t key = k_spin_lock(&lock);
+
+                notify_errors++;
+                dropped += n;
+                k_spin_unlock(&lock, key);
+                break;
+            }
+            notifications++;
+            sent_samples += n;
+            sent_bytes += len;
+        }
+    }
+}
+
+K_THREAD_DEFINE(telemetry_tid, TELEMETRY_STACK_SIZE, telemetry_thread, NULL, NULL, NULL,
+                TELEMETRY_PRIORITY, 0, 0);
+
+// ATT MTU of the connection, from the att_mtu_updated callback
+void telemetry_set_mtu(uint16_t mtu)
+{
+    att_mtu = mtu;
+}
+
+// Throughput over the time notifications were enabled, and samples that never
+// left the device because the ring was full or a notification failed
+void telemetry_print_stats(void)
+{
+#if PERF_ENABLED
+    uint32_t ms = stream_ms + (atomic_get(&streaming) ? k_uptime_get() - stream_start : 0);
+
+    printk("[perf] telemetry: %u ms streamed, %u samples in %u notifications, %u bytes/s\n", ms,
+           sent_samples, notifications, ms ? (uint32_t)((uint64_t)sent_bytes * 1000 / ms) : 0);
+    printk("[perf] telemetry: %u recorded, %u dropped (%u.%u%%), %u notify errors\n", recorded,
+           dropped, recorded ? dropped * 100 / recorded : 0,
+           recorded ? dropped * 1000 / recorded % 10 : 0, notify_errors);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/uuid.h>
+
+// Raw input stream for debugging field units, only runs while a client has
+// notifications enabled on the telemetry characteristic
+#define BT_UUID_TELEMETRY_SERVICE_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef1)
+
+#define BT_UUID_TELEMETRY_STREAM_VAL \
+    BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef7)
+
+#define TELEMETRY_RING_SIZE 256 // samples, power of two
+#define TELEMETRY_FLUSH_MS 20   // a partly filled notification waits at most this long
+#define TELEMETRY_NOTIFY_MAX 244 // payload at CONFIG_BT_L2CAP_TX_MTU=247
+#define TELEMETRY_STACK_SIZE 1024
+#define TELEMETRY_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+// Connection wanted while streaming: 7.5..15 ms interval, no latency, 4 s timeout
+#define TELEMETRY_CONN_PARAM BT_LE_CONN_PARAM(6, 12, 0, 400)
+
+enum telemetry_source {
+    TELEMETRY_SRC_JOYSTICK, // a, b = X, Y ADC counts before filtering
+    TELEMETRY_SRC_QDEC,     // a = degrees, b = 1/10000 degree of one QDEC report
+};
+
+// Wire format, little endian, packed back to back into each notification.
+// seq counts every recorded sample, gaps are samples dropped on the device.
+struct telemetry_sample {
+    uint16_t time_ms; // low bits of cts_now_ms()
+    uint8_t source;
+    uint8_t seq;
+    int16_t a;
+    int16_t b;
+} __packed;
+
+// Safe from interrupts, returns at once while streaming is off
+void telemetry_record(enum telemetry_source source, int16_t a, int16_t b);
+void telemetry_set_mtu(uint16_t mtu);
+void telemetry_print_stats(void);
+
+#endif // TELEMETRY_H
\ No newline at end of file
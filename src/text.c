@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include <zephyr/sys/printk.h>
+
+#include "text.h"
+#include "font.h"
+#include "led.h"
+#include "perf.h"
+
+#define GLYPH_COLUMNS (FONT_WIDTH + FONT_SPACING)
+
+// The whole string laid out once as canvas columns, with a blank canvas
+// before and after it, so it enters from the right and leaves to the left.
+// Frame n shows strip[n .. n + LED_CANVAS_WIDTH - 1].
+static uint8_t strip[LED_CANVAS_WIDTH + TEXT_MAX_LEN * GLYPH_COLUMNS + LED_CANVAS_WIDTH];
+static size_t strip_len;
+static size_t offset;
+static bool repeat;
+static atomic_t running;
+
+static PERF_STAT_DEFINE_HIRES(frame_stat, "text frame");
+
+static void text_frame_handler(struct k_work *work);
+static K_WORK_DEFINE(text_frame_work, text_frame_handler);
+
+static void text_timer_expiry(struct k_timer *timer)
+{
+    k_work_submit(&text_frame_work);
+}
+
+static K_TIMER_DEFINE(text_timer, text_timer_expiry, NULL);
+
+static void text_frame_handler(struct k_work *work)
+{
+    if (!atomic_get(&running)) {
+        return;
+    }
+
+    uint32_t start = perf_start_hires();
+
+    led_draw_columns(0, &strip[offset], LED_CANVAS_WIDTH);
+    led_flush();
+
+    perf_stop(&frame_stat, start);
+
+    if (++offset + LED_CANVAS_WIDTH > strip_len) {
+        if (!repeat) {
+            text_stop();
+            return;
+        }
+        offset = 0;
+    }
+}
+
+// Scroll str across the whole canvas at TEXT_SCROLL_FPS, replaces any text
+// still running. The string is copied, the caller's buffer can change after.
+int text_scroll(const char *str, bool repeat_text)
+{
+    size_t len = MIN(strlen(str), TEXT_MAX_LEN);
+
+    text_stop();
+
+    memset(strip, 0, sizeof(strip));
+    for (size_t i = 0; i < len; i++) {
+        memcpy(&strip[LED_CANVAS_WIDTH + i * GLYPH_COLUMNS], font_glyph(str[i]), FONT_WIDTH);
+    }
+
+    strip_len = LED_CANVAS_WIDTH + len * GLYPH_COLUMNS + LED_CANVAS_WIDTH;
+    offset = 0;
+    repeat = repeat_text;
+    atomic_set(&running, 1);
+    k_timer_start(&text_timer, K_NO_WAIT, K_MSEC(1000 / TEXT_SCROLL_FPS));
+    return 0;
+}
+
+void text_stop(void)
+{
+    atomic_clear(&running);
+    k_timer_stop(&text_timer);
+    k_work_cancel(&text_frame_work);
+}
+
+void text_print_stats(void)
+{
+#if PERF_ENABLED
+    printk("[perf] text: font %u bytes flash, strip %u bytes RAM\n", sizeof(font5x7),
+           sizeof(strip));
+    perf_print(&frame_stat);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <zephyr/kernel.h>
+
+#define TEXT_SCROLL_FPS 20 // columns per second
+#define TEXT_MAX_LEN 48 // longer strings are cut
+
+int text_scroll(const char *str, bool repeat);
+void text_stop(void);
+void text_print_stats(void);
+
+#endif // TEXT_H
\ No newline at end of file
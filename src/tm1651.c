@@ -0,0 +1,229 @@
+#define DT_DRV_COMPAT titanmec_tm1651
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#include "tm1651.h"
+#include "perf.h"
+
+LOG_MODULE_REGISTER(tm1651, CONFIG_SAFE_TM1651_LOG_LEVEL);
+
+#define TM1651_CMD_ADDR_FIXED 0x44
+#define TM1651_CMD_ADDR_00H 0xC0
+#define TM1651_CMD_DISPLAY_ON 0x88
+
+#define TM1651_WORKQ_STACK_SIZE 512
+#define TM1651_WORKQ_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+static const uint8_t leveltab[TM1651_MAX_LEVEL + 1] = {
+    0x00, 0x20, 0x40, 0x60, 0x70, 0x78, 0x7a, 0x7c, 0x7d, 0x7e, 0x7f // Level 0~10
+};
+
+struct tm1651_config {
+    struct gpio_dt_spec clk;
+    struct gpio_dt_spec dio;
+    uint32_t bit_delay_us;
+    uint8_t brightness;
+};
+
+struct tm1651_data {
+    const struct device *dev;
+    struct k_work work;
+    atomic_t level; // requested by the caller
+    atomic_t brightness;
+    int shown_level; // last value written to the chip, -1 = unknown
+    int shown_brightness;
+};
+
+K_THREAD_STACK_DEFINE(tm1651_workq_stack, TM1651_WORKQ_STACK_SIZE);
+static struct k_work_q tm1651_workq;
+static bool tm1651_workq_started;
+
+static PERF_STAT_DEFINE(transfer_stat, "tm1651 transfer");
+
+// CLK and DIO are open-drain: 0 pulls the line low, 1 releases it to the pull-up.
+static inline void bit_delay(const struct tm1651_config *cfg)
+{
+    k_busy_wait(cfg->bit_delay_us);
+}
+
+static void start(const struct tm1651_config *cfg)
+{
+    gpio_pin_set_dt(&cfg->dio, 0);
+    bit_delay(cfg);
+}
+
+static void stop(const struct tm1651_config *cfg)
+{
+    gpio_pin_set_dt(&cfg->dio, 0);
+    bit_delay(cfg);
+    gpio_pin_set_dt(&cfg->clk, 1);
+    bit_delay(cfg);
+    gpio_pin_set_dt(&cfg->dio, 1);
+    bit_delay(cfg);
+}
+
+// Send one byte LSB first, returns 0 when the chip acknowledged it.
+static int write_byte(const struct tm1651_config *cfg, uint8_t data)
+{
+    for (uint8_t i = 0; i < 8; i++) {
+        gpio_pin_set_dt(&cfg->clk, 0);
+        bit_delay(cfg);
+        gpio_pin_set_dt(&cfg->dio, data & 0x01);
+        bit_delay(cfg);
+        gpio_pin_set_dt(&cfg->clk, 1);
+        bit_delay(cfg);
+        data >>= 1;
+    }
+
+    // ninth clock: the chip pulls DIO low as ACK
+    gpio_pin_set_dt(&cfg->clk, 0);
+    gpio_pin_set_dt(&cfg->dio, 1);
+    bit_delay(cfg);
+    gpio_pin_set_dt(&cfg->clk, 1);
+    bit_delay(cfg);
+    int ack = gpio_pin_get_dt(&cfg->dio);
+    if (ack == 0) {
+        gpio_pin_set_dt(&cfg->dio, 0);
+    }
+    bit_delay(cfg);
+    gpio_pin_set_dt(&cfg->clk, 0);
+    bit_delay(cfg);
+
+    return ack == 0 ? 0 : -EIO;
+}
+
+static int write_display(const struct tm1651_config *cfg, uint8_t level, uint8_t brightness)
+{
+    int err = 0;
+
+    start(cfg);
+    err |= write_byte(cfg, TM1651_CMD_ADDR_FIXED);
+    stop(cfg);
+
+    start(cfg);
+    err |= write_byte(cfg, TM1651_CMD_ADDR_00H);
+    err |= write_byte(cfg, leveltab[level]);
+    stop(cfg);
+
+    start(cfg);
+    err |= write_byte(cfg, TM1651_CMD_DISPLAY_ON + brightness);
+    stop(cfg);
+
+    return err;
+}
+
+static void tm1651_work_handler(struct k_work *work)
+{
+    struct tm1651_data *data = CONTAINER_OF(work, struct tm1651_data, work);
+    const struct tm1651_config *cfg = data->dev->config;
+
+    // a request posted during the transfer resubmits the work, so only the
+    // latest value is ever written and nothing is lost
+    int level = atomic_get(&data->level);
+    int brightness = atomic_get(&data->brightness);
+
+    if (level == data->shown_level && brightness == data->shown_brightness) {
+        return;
+    }
+
+    uint32_t start_cyc = perf_start();
+    int err = write_display(cfg, level, brightness);
+    perf_stop(&transfer_stat, start_cyc);
+
+    if (err < 0) {
+        LOG_ERR("TM1651 did not acknowledge level %d", level);
+        data->shown_level = -1;
+        return;
+    }
+
+    data->shown_level = level;
+    data->shown_brightness = brightness;
+}
+
+int tm1651_set_level(const struct device *dev, uint8_t level)
+{
+    struct tm1651_data *data = dev->data;
+
+    if (level > TM1651_MAX_LEVEL) {
+        return -EINVAL;
+    }
+
+    atomic_set(&data->level, level);
+    k_work_submit_to_queue(&tm1651_workq, &data->work);
+    return 0;
+}
+
+int tm1651_set_brightness(const struct device *dev, uint8_t brightness)
+{
+    struct tm1651_data *data = dev->data;
+
+    if (brightness > TM1651_MAX_BRIGHTNESS) {
+        return -EINVAL;
+    }
+
+    atomic_set(&data->brightness, brightness);
+    k_work_submit_to_queue(&tm1651_workq, &data->work);
+    return 0;
+}
+
+void tm1651_print_stats(void)
+{
+    perf_print(&transfer_stat);
+}
+
+static int tm1651_init(const struct device *dev)
+{
+    const struct tm1651_config *cfg = dev->config;
+    struct tm1651_data *data = dev->data;
+    int err;
+
+    if (!gpio_is_ready_dt(&cfg->clk) || !gpio_is_ready_dt(&cfg->dio)) {
+        return -ENODEV;
+    }
+
+    // configured once, the transfer only toggles output levels
+    err = gpio_pin_configure_dt(&cfg->clk, GPIO_OUTPUT_HIGH | GPIO_OPEN_DRAIN);
+    if (err < 0) {
+        return err;
+    }
+
+    err = gpio_pin_configure_dt(&cfg->dio, GPIO_INPUT | GPIO_OUTPUT_HIGH | GPIO_OPEN_DRAIN);
+    if (err < 0) {
+        return err;
+    }
+
+    if (!tm1651_workq_started) {
+        k_work_queue_init(&tm1651_workq);
+        k_work_queue_start(&tm1651_workq, tm1651_workq_stack,
+                           K_THREAD_STACK_SIZEOF(tm1651_workq_stack), TM1651_WORKQ_PRIORITY,
+                           &(struct k_work_queue_config){ .name = "tm1651" });
+        tm1651_workq_started = true;
+    }
+
+    data->dev = dev;
+    data->shown_level = -1;
+    data->shown_brightness = -1;
+    atomic_set(&data->level, 0);
+    atomic_set(&data->brightness, cfg->brightness);
+    k_work_init(&data->work, tm1651_work_handler);
+
+    return 0;
+}
+
+#define TM1651_DEFINE(inst)                                                        \
+    static const struct tm1651_config tm1651_config_##inst = {                     \
+        .clk = GPIO_DT_SPEC_INST_GET(inst, clk_gpios),                             \
+        .dio = GPIO_DT_SPEC_INST_GET(inst, dio_gpios),                             \
+        .bit_delay_us = DT_INST_PROP(inst, bit_delay_us),                          \
+        .brightness = DT_INST_PROP(inst, brightness),                              \
+    };                                                                             \
+    static struct tm1651_data tm1651_data_##inst;                                  \
+    DEVICE_DT_INST_DEFINE(inst, tm1651_init, NULL, &tm1651_data_##inst,            \
+                          &tm1651_config_##inst, POST_KERNEL,                      \
+                          CONFIG_APPLICATION_INIT_PRIORITY, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(TM1651_DEFINE)
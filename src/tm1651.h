@@ -0,0 +1,16 @@
+#ifndef TM1651_H
+#define TM1651_H
+
+#include <zephyr/device.h>
+
+#define TM1651_MAX_LEVEL 10
+#define TM1651_MAX_BRIGHTNESS 7
+
+// Both calls only record the request and queue the transfer on the driver's
+// work queue, they never wait for the bus. Requests that arrive while a
+// transfer is running are merged: the latest value wins.
+int tm1651_set_level(const struct device *dev, uint8_t level);
+int tm1651_set_brightness(const struct device *dev, uint8_t brightness);
+void tm1651_print_stats(void);
+
+#endif // TM1651_H
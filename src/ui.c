@@ -0,0 +1,144 @@
+#include "ui.h"
+#include "led.h"
+#include "anim.h"
+
+// Both timers only post an EVENT_UI, every draw happens in main()
+enum ui_timer {
+    UI_TIMER_FEEDBACK,
+    UI_TIMER_ARROW,
+};
+
+// The timers clear these themselves, a dropped EVENT_UI only delays a redraw
+static atomic_t feedback = ATOMIC_INIT(UI_FEEDBACK_NONE); // on screen until its timer expires
+static atomic_t feedback_ended = ATOMIC_INIT(UI_FEEDBACK_NONE); // until main() follows up
+static atomic_t arrow_hold;
+static enum gesture_dir arrow_shown = GESTURE_NONE;
+static enum gesture_dir arrow_pending = GESTURE_NONE;
+
+static void post_timer_event(enum ui_timer timer)
+{
+    struct app_event ev = { .type = EVENT_UI, .ui = timer };
+
+    app_event_post(&ev);
+}
+
+static void feedback_expiry(struct k_timer *timer)
+{
+    atomic_set(&feedback_ended, atomic_set(&feedback, UI_FEEDBACK_NONE));
+    post_timer_event(UI_TIMER_FEEDBACK);
+}
+
+static void arrow_expiry(struct k_timer *timer)
+{
+    atomic_clear(&arrow_hold);
+    post_timer_event(UI_TIMER_ARROW);
+}
+
+static K_TIMER_DEFINE(feedback_timer, feedback_expiry, NULL);
+static K_TIMER_DEFINE(arrow_timer, arrow_expiry, NULL);
+
+static void draw_arrow(enum gesture_dir dir)
+{
+    led_off_all();
+
+    switch (dir) {
+    case GESTURE_CENTER:
+        led_on_center();
+        break;
+    case GESTURE_LEFT:
+        led_on_left();
+        break;
+    case GESTURE_RIGHT:
+        led_on_right();
+        break;
+    case GESTURE_UP:
+        led_on_up();
+        break;
+    case GESTURE_DOWN:
+        led_on_down();
+        break;
+    default:
+        break;
+    }
+    led_flush(); // pushes the deferred blank when no arrow was drawn
+
+    arrow_shown = dir;
+    atomic_set(&arrow_hold, true);
+    k_timer_start(&arrow_timer, K_MSEC(UI_ARROW_HOLD_MS), K_NO_WAIT);
+}
+
+// Show a result face, replaces whatever is on the matrix
+void ui_show_feedback(enum ui_feedback fb)
+{
+    k_timer_stop(&arrow_timer);
+    k_timer_stop(&feedback_timer);
+    atomic_clear(&arrow_hold);
+    atomic_set(&feedback_ended, UI_FEEDBACK_NONE); // the new face replaces any follow-up
+    arrow_pending = GESTURE_NONE;
+
+    led_off_all();
+    bool ok = fb == UI_FEEDBACK_JOYSTICK_OK || fb == UI_FEEDBACK_CODE_OK ||
+              fb == UI_FEEDBACK_OPENED;
+
+    anim_play(ok ? anim_success : anim_failure);
+
+    atomic_set(&feedback, fb);
+    k_timer_start(&feedback_timer, K_MSEC(UI_FEEDBACK_MS), K_NO_WAIT);
+}
+
+// True while a result face is on screen, input must not draw over it
+bool ui_busy(void)
+{
+    return atomic_get(&feedback) != UI_FEEDBACK_NONE;
+}
+
+// Draw the joystick direction now, or once the previous arrow has been up for
+// UI_ARROW_HOLD_MS. Only the latest direction is kept.
+void ui_show_arrow(enum gesture_dir dir)
+{
+    if (ui_busy()) {
+        return;
+    }
+
+    arrow_pending = dir;
+    if (!atomic_get(&arrow_hold)) {
+        draw_arrow(dir);
+    }
+}
+
+// Handles an EVENT_UI, only the arrow held back by the previous one is drawn
+void ui_handle_event(const struct app_event *ev)
+{
+    // a newer arrow that is still held makes this event stale
+    if (ev->ui != UI_TIMER_ARROW || atomic_get(&arrow_hold)) {
+        return;
+    }
+    if (!ui_busy() && arrow_pending != arrow_shown) {
+        draw_arrow(arrow_pending);
+    }
+}
+
+// Returns the feedback screen that ended since the last call, once, or
+// UI_FEEDBACK_NONE. main() calls it after every event, so a dropped EVENT_UI
+// only delays the follow-up until the next event.
+enum ui_feedback ui_feedback_ended(void)
+{
+    enum ui_feedback ended = atomic_set(&feedback_ended, UI_FEEDBACK_NONE);
+
+    if (ended != UI_FEEDBACK_NONE) {
+        anim_stop();
+    }
+    return ended;
+}
+
+// Stop every timed state, used when a stage is left early
+void ui_cancel(void)
+{
+    k_timer_stop(&feedback_timer);
+    k_timer_stop(&arrow_timer);
+    anim_stop();
+    atomic_set(&feedback, UI_FEEDBACK_NONE);
+    atomic_set(&feedback_ended, UI_FEEDBACK_NONE);
+    atomic_clear(&arrow_hold);
+    arrow_pending = GESTURE_NONE;
+}
\ No newline at end of file
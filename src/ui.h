@@ -0,0 +1,34 @@
+#ifndef UI_H
+#define UI_H
+
+#include <zephyr/kernel.h>
+
+#include "events.h"
+#include "gesture.h"
+
+// How long a result face stays on the matrix before input is shown again
+#define UI_FEEDBACK_MS 3000
+
+// An arrow stays up at least this long, newer directions are drawn after it
+#define UI_ARROW_HOLD_MS 100
+
+// Timed screens, main() decides what follows when one ends
+enum ui_feedback {
+    UI_FEEDBACK_NONE,
+    UI_FEEDBACK_JOYSTICK_OK,
+    UI_FEEDBACK_JOYSTICK_FAIL,
+    UI_FEEDBACK_CODE_OK,
+    UI_FEEDBACK_CODE_FAIL,
+    UI_FEEDBACK_KEYPAD_FAIL,
+    UI_FEEDBACK_OPENED,  // all three codes entered, before the final message
+    UI_FEEDBACK_TIMEOUT, // the countdown ran out, before the final message
+};
+
+void ui_show_feedback(enum ui_feedback fb);
+bool ui_busy(void);
+void ui_show_arrow(enum gesture_dir dir);
+void ui_handle_event(const struct app_event *ev);
+enum ui_feedback ui_feedback_ended(void);
+void ui_cancel(void);
+
+#endif // UI_H
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <time.h>
+
+#include <zephyr/ztest.h>
+
+#include "countdown.h"
+#include "events.h"
+
+// Longest a host thread may oversleep before the test calls it late
+#define HOST_SLACK_MS 50
+
+// The host monotonic clock, not derived from the kernel timer under test
+static int64_t host_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+}
+
+static void drain_events(void)
+{
+    struct app_event ev;
+
+    while (app_event_wait(&ev, K_NO_WAIT) == 0) {
+    }
+}
+
+static void countdown_before(void *fixture)
+{
+    countdown_stop();
+    drain_events();
+}
+
+ZTEST(countdown, test_deadline_against_host_clock)
+{
+    struct app_event ev;
+    uint32_t ticks = 0;
+
+    int64_t host_start = host_ms();
+    countdown_start();
+
+    do {
+        zassert_ok(app_event_wait(&ev, K_SECONDS(COUNTDOWN_SECONDS + 1)), "countdown stalled");
+        if (ev.type == EVENT_TICK) {
+            ticks++;
+            zassert_true(ev.remaining_ms > 0);
+        }
+    } while (ev.type != EVENT_TIMEOUT);
+
+    int64_t elapsed = host_ms() - host_start;
+
+    zassert_equal(ticks, COUNTDOWN_SECONDS - 1, "%u ticks before the timeout", ticks);
+    zassert_equal(ev.remaining_ms, 0);
+    zassert_true(elapsed >= COUNTDOWN_SECONDS * MSEC_PER_SEC, "ended early, %lld ms", elapsed);
+    zassert_true(elapsed < COUNTDOWN_SECONDS * MSEC_PER_SEC + HOST_SLACK_MS,
+                 "late ticks added up, %lld ms", elapsed);
+    zassert_true(countdown_expired());
+    zassert_false(countdown_running());
+}
+
+ZTEST(countdown, test_expiry_latched_on_full_queue)
+{
+    struct app_event filler = { .type = EVENT_KEY };
+    struct app_event ev;
+
+    countdown_start();
+    zassert_false(countdown_expired());
+
+    // every tick and the timeout itself are dropped from here on
+    for (int i = 0; i < APP_EVENT_QUEUE_LEN; i++) {
+        filler.timestamp = 0;
+        zassert_ok(app_event_post(&filler));
+    }
+    k_sleep(K_MSEC(COUNTDOWN_SECONDS * MSEC_PER_SEC + HOST_SLACK_MS));
+
+    zassert_true(countdown_expired(), "lost timeout was not latched");
+    while (app_event_wait(&ev, K_NO_WAIT) == 0) {
+        zassert_equal(ev.type, EVENT_KEY, "queue was expected to stay full");
+    }
+}
+
+ZTEST(countdown, test_level_rounds_partial_seconds_up)
+{
+    zassert_equal(countdown_level(120000), 10);
+    zassert_equal(countdown_level(119001), 10);
+    zassert_equal(countdown_level(119000), 9);
+    zassert_equal(countdown_level(12001), 1);
+    zassert_equal(countdown_level(12000), 0);
+    zassert_equal(countdown_level(0), 0);
+}
+
+ZTEST_SUITE(countdown, NULL, NULL, countdown_before, NULL, NULL);
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include <zephyr/ztest.h>
+
+#include "gesture.h"
+#include "traces.h"
+
+#define MAX_EVENTS 8
+
+static const struct gesture_config config = {
+    .deadzone = GESTURE_DEADZONE,
+    .hysteresis = GESTURE_HYSTERESIS,
+    .dwell_ms = GESTURE_DWELL_MS,
+};
+
+// Feed a whole trace, returns the number of reported events
+static size_t replay(const struct trace_sample *trace, size_t len, struct gesture_event *events)
+{
+    struct gesture g;
+    size_t n = 0;
+
+    gesture_init(&g, &config);
+    for (size_t i = 0; i < len; i++) {
+        struct gesture_event ev;
+
+        if (gesture_feed(&g, trace[i].x, trace[i].y, trace[i].t_ms, &ev)) {
+            zassert_true(n < MAX_EVENTS, "too many events");
+            events[n++] = ev;
+        }
+    }
+    return n;
+}
+
+ZTEST(gesture, test_deadzone_jitter)
+{
+    struct gesture_event events[MAX_EVENTS];
+    size_t n = replay(trace_rest_jitter, ARRAY_SIZE(trace_rest_jitter), events);
+
+    zassert_equal(n, 1, "noise below the deadzone reported %zu events", n);
+    zassert_equal(events[0].dir, GESTURE_CENTER);
+    zassert_false(events[0].entry);
+}
+
+ZTEST(gesture, test_hysteresis_at_edge)
+{
+    struct gesture_event events[MAX_EVENTS];
+    size_t n = replay(trace_edge_hysteresis, ARRAY_SIZE(trace_edge_hysteresis), events);
+
+    zassert_equal(n, 3, "wobble inside the band reported %zu events", n);
+    zassert_equal(events[0].dir, GESTURE_CENTER);
+    zassert_equal(events[1].dir, GESTURE_RIGHT);
+    zassert_true(events[1].entry, "a move out of center is an entry");
+    zassert_equal(events[2].dir, GESTURE_CENTER);
+    // released at 130 ms, below the exit threshold from then on
+    zassert_true(events[2].timestamp >= 130 + GESTURE_DWELL_MS);
+}
+
+ZTEST(gesture, test_dwell_rejection)
+{
+    struct gesture_event events[MAX_EVENTS];
+    size_t n = replay(trace_dwell_reject, ARRAY_SIZE(trace_dwell_reject), events);
+
+    zassert_equal(n, 2, "the short flick was reported (%zu events)", n);
+    zassert_equal(events[0].dir, GESTURE_CENTER);
+    zassert_equal(events[1].dir, GESTURE_UP);
+    zassert_true(events[1].entry);
+    // only the hold starting at 90 ms can satisfy the dwell time
+    zassert_true(events[1].timestamp >= 90 + GESTURE_DWELL_MS);
+}
+
+ZTEST_SUITE(gesture, NULL, NULL, NULL, NULL, NULL);
\ No newline at end of file
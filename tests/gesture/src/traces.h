@@ -0,0 +1,52 @@
+#ifndef TRACES_H
+#define TRACES_H
+
+#include <stdint.h>
+
+// Joystick traces as the ADC interrupt feeds them to the classifier: time in ms and
+// the scaled X/Y vector (full deflection = 1024), decimated to 5 ms.
+
+struct trace_sample {
+    uint32_t t_ms;
+    int16_t x;
+    int16_t y;
+};
+
+// Stick at rest with ADC noise and a few spikes that stay below the deadzone
+// minus hysteresis. Only the initial CENTER may be reported.
+static const struct trace_sample trace_rest_jitter[] = {
+    { 0, 12, -8 },    { 5, -30, 22 },   { 10, 41, 5 },    { 15, -6, -44 },
+    { 20, 18, 31 },   { 25, 3, -12 },   { 30, -25, 9 },   { 35, 36, -17 },
+    { 40, 240, 15 },  { 45, -11, 250 }, { 50, 7, -3 },    { 55, -248, 40 },
+    { 60, 22, -230 }, { 65, -9, 14 },   { 70, 31, -28 },  { 75, 255, 0 },
+    { 80, -14, 6 },   { 85, 2, -256 },  { 90, 19, 11 },   { 95, -37, 26 },
+    { 100, 8, -5 },   { 105, 44, -39 }, { 110, -20, 3 },  { 115, 6, 17 },
+};
+
+// Pushed right past the entry threshold, then wobbling inside the hysteresis
+// band around the deadzone, then released. Expected: CENTER, RIGHT, CENTER.
+static const struct trace_sample trace_edge_hysteresis[] = {
+    { 0, 10, 4 },     { 5, -6, 2 },     { 10, 3, -9 },    { 15, 8, 1 },
+    { 20, 2, 0 },     { 25, -4, 6 },    { 30, 5, -3 },    { 35, 1, 2 },
+    { 40, 180, 10 },  { 45, 420, 12 },  { 50, 560, 8 },   { 55, 610, -6 },
+    { 60, 640, 4 },   { 65, 630, 9 },   { 70, 600, -2 },  { 75, 590, 0 },
+    { 80, 585, 5 },   { 85, 500, 7 },   { 90, 330, -11 }, { 95, 470, 5 },
+    { 100, 290, 3 },  { 105, 505, -8 }, { 110, 270, 2 },  { 115, 380, 6 },
+    { 120, 480, -4 }, { 125, 300, 1 },  { 130, 150, 0 },  { 135, 40, -2 },
+    { 140, 6, 3 },    { 145, -3, 1 },   { 150, 2, -2 },   { 155, 0, 0 },
+    { 160, 4, 1 },    { 165, -1, 2 },   { 170, 3, 0 },
+};
+
+// A 20 ms flick up, shorter than the dwell time, then a deliberate hold up.
+// Expected: CENTER, then UP only for the hold.
+static const struct trace_sample trace_dwell_reject[] = {
+    { 0, 5, -7 },     { 5, -3, 4 },     { 10, 6, 2 },     { 15, 1, -1 },
+    { 20, -2, 3 },    { 25, 4, 0 },     { 30, 0, 5 },     { 35, -5, 1 },
+    { 40, 20, 700 },  { 45, 15, 820 },  { 50, 8, 790 },   { 55, -4, 760 },
+    { 60, 3, 90 },    { 65, -6, 12 },   { 70, 2, -4 },    { 75, 5, 3 },
+    { 80, -1, 2 },    { 85, 4, -3 },    { 90, 10, 650 },  { 95, 6, 800 },
+    { 100, -3, 830 }, { 105, 2, 845 },  { 110, 7, 850 },  { 115, -8, 840 },
+    { 120, 4, 835 },  { 125, 1, 842 },  { 130, -2, 838 },
+};
+
+#endif // TRACES_H
\ No newline at end of file